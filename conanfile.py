@@ -15,11 +15,11 @@ class HelloConan(ConanFile):
 
     # Binary configuration
     settings = "os", "compiler", "build_type", "arch"
-    options = {"shared": [True, False], "fPIC": [True, False]}
-    default_options = {"shared": False, "fPIC": True}
+    options = {"shared": [True, False], "fPIC": [True, False], "with_lz4": [True, False]}
+    default_options = {"shared": False, "fPIC": True, "with_lz4": False}
 
     # Sources are located in the same place as this recipe, copy them to the recipe
-    exports_sources = "CMakeLists.txt", "*.cmake", "sky/*", "demo/*"
+    exports_sources = "CMakeLists.txt", "*.cmake", "sky/*", "demo/*", "tools/*"
     generators = "CMakeDeps"
 
     def config_options(self):
@@ -33,12 +33,15 @@ class HelloConan(ConanFile):
         self.requires("sdl_image/2.0.5")
         self.requires("libpng/1.6.40")
         self.requires("spdlog/1.10.0")
+        if self.options.with_lz4:
+            self.requires("lz4/1.9.4")
 
     def layout(self):
         cmake_layout(self)
 
     def generate(self):
         tc = CMakeToolchain(self)
+        tc.variables["SKY_WITH_LZ4"] = "On" if self.options.with_lz4 else "Off"
         tc.generate()
 
     def build(self):
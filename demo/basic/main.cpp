@@ -37,11 +37,12 @@ public:
         SDL_Rect    destRect {intPos.x, intPos.y, p->getWidth(), p->getHeight()};
         p->renderTo(renderer, nullptr, &destRect);
 
-        auto labelTex = DemoAssets::primaryFont.get()->renderSolid(
+        // Positions repeat while the player stands still, those frames reuse the texture
+        auto labelTex = DemoAssets::primaryFont.get()->renderCached(
             fmt::format("Pos: {}, {}", intPos.x, intPos.y), sky::Color {255, 255, 0, 255});
-        destRect = {10, 20, labelTex.getWidth(), labelTex.getHeight()};
+        destRect = {10, 20, labelTex->getWidth(), labelTex->getHeight()};
 
-        labelTex.renderTo(renderer, nullptr, &destRect);
+        labelTex->renderTo(renderer, nullptr, &destRect);
     }
 
     void onUpdate(float dt) override
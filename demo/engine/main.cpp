@@ -32,6 +32,8 @@ public:
         sky::SharedObject uiObject = sky::Object::from(ui);
         uiObject->position = {8, 8};
         addUi(uiObject);
+
+        enablePerfHud(DemoAssets::primaryFont.get());
     }
 
     void onUpdate(float dt) override
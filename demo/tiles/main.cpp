@@ -1,8 +1,11 @@
+#include <Autotile.h>
 #include <SkyEngine.h>
 #include <SkyUi.h>
 #include <Tiles.h>
 #include <mist/Matrix.h>
 #include <mist/Noise.h>
+#include <cmath>
+#include <memory>
 #include <spdlog/spdlog.h>
 
 namespace demo
@@ -14,6 +17,13 @@ static constexpr auto tileSize = 32;
 static constexpr auto numDirtTiles = 8;
 static constexpr auto numGrassTiles = 16;
 
+// Map layers: noise ground, autotiled paths drawn over it, and the path terrain data
+static constexpr auto groundLayer = 0;
+static constexpr auto pathLayer = 1;
+static constexpr auto pathTerrainLayer = 2;
+static constexpr auto numLayers = 3;
+static constexpr sky::TileMap::CellType pathTerrain = 1;
+
 struct TilesetLoader {
     using Arg = nullptr_t;
 
@@ -21,6 +31,7 @@ struct TilesetLoader {
     {
         using namespace sky::TilePainters;
         sky::TilesetBuilder builder {tileSize};
+        builder.setCacheDirectory("cache");
 
         auto dirtGradient = hsvValueRamp(50.0f, 0.6f, 0.2f, 0.5f, numDirtTiles);
         auto grassGradient = hsvValueRamp(120.0f, 0.5f, 0.3f, 1.0f, numGrassTiles);
@@ -45,9 +56,15 @@ public:
     void onLoad() override
     {
         auto tileset = DemoAssets::tileset.get();
-        tilemap = std::make_shared<sky::TileMap>(tileset, 32, 32);
+        tilemap = std::make_shared<sky::TileMap>(tileset, 32, 32, numLayers);
+        tilemap->setLayerVisible(pathTerrainLayer, false);
         add(sky::Object::from(tilemap));
 
+        // The grass tiles stand in for path art: each of the 16 neighbor masks gets a shade
+        pathTiler = std::make_unique<PathTiler>(tilemap, pathTerrainLayer, pathLayer,
+                                                PathTiler::Mode::FourNeighbors);
+        pathTiler->setSequentialRule(pathTerrain, numDirtTiles);
+
         selector = sky::Object::from(DemoAssets::selector.get());
         selector->position = {0.5, 0.5};
         add(selector);
@@ -68,8 +85,9 @@ public:
             .build();
 
         auto tilePainter = [&](const mist::Point2i &p, double v) {
-            tilemap->at(p) =
+            const auto tile =
                 mist::roundi(std::clamp(v, 0.0, 1.0) * (numDirtTiles + numGrassTiles - 1));
+            tilemap->at(groundLayer, p) = static_cast<sky::TileMap::CellType>(tile);
         };
 
         noiseMap.foreachKeyValue(tilePainter);
@@ -83,13 +101,28 @@ public:
         case SDL_SCANCODE_DOWN: selector->position.y++; break;
         case SDL_SCANCODE_LEFT: selector->position.x--; break;
         case SDL_SCANCODE_RIGHT: selector->position.x++; break;
+        case SDL_SCANCODE_SPACE: togglePath(); break;
         default: break;
         }
     }
 
 private:
-    sky::SharedTileMap tilemap;
-    sky::SharedObject  selector;
+    using PathTiler = sky::Autotiler<sky::TileMap::CellType>;
+
+    sky::SharedTileMap         tilemap;
+    sky::SharedObject          selector;
+    std::unique_ptr<PathTiler> pathTiler;
+
+    void togglePath()
+    {
+        const mist::Point2i p {static_cast<int>(std::floor(selector->position.x)),
+                               static_cast<int>(std::floor(selector->position.y))};
+        if (p.x < 0 || p.y < 0 || p.x >= tilemap->getWidth() || p.y >= tilemap->getHeight())
+            return;
+
+        const auto hasPath = pathTiler->getTerrain(p) == pathTerrain;
+        pathTiler->setTerrain(p, hasPath ? sky::TileMap::Empty : pathTerrain);
+    }
 };
 
 } // namespace demo
@@ -0,0 +1,46 @@
+#include "Sky.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef SKY_COUNT_ALLOCATIONS
+
+namespace
+{
+
+std::atomic<std::int64_t> allocations {0}; // NOLINT
+
+} // namespace
+
+// Array and nothrow forms call these by default, so every allocation is counted once
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto *p = std::malloc(size != 0 ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+std::int64_t sky::allocationCount() noexcept
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+std::int64_t sky::allocationCount() noexcept
+{
+    return -1;
+}
+
+#endif
@@ -0,0 +1,249 @@
+#include "AssetPack.h"
+#include "TileMapFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#ifdef SKY_WITH_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+using namespace sky;
+
+namespace
+{
+
+std::runtime_error packError(const std::string &what, std::string_view file)
+{
+    return std::runtime_error(what + ": " + std::string(file));
+}
+
+std::uint64_t alignUp(std::uint64_t offset)
+{
+    constexpr auto a = AssetPackHeader::Alignment;
+    return (offset + a - 1) / a * a;
+}
+
+std::vector<char> readFile(const std::string &file)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in) throw packError("Open asset file", file);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+#ifdef SKY_WITH_LZ4
+
+/// Compressed contents, or empty if compression would not make them smaller
+std::vector<char> compress(const std::vector<char> &data)
+{
+    if (data.empty() || data.size() > LZ4_MAX_INPUT_SIZE) return {};
+
+    const auto        size = static_cast<int>(data.size());
+    std::vector<char> out(static_cast<std::size_t>(LZ4_compressBound(size)));
+    const auto        stored = LZ4_compress_HC(data.data(), out.data(), size,
+                                               static_cast<int>(out.size()), LZ4HC_CLEVEL_DEFAULT);
+    if (stored <= 0 || stored >= size) return {};
+    out.resize(static_cast<std::size_t>(stored));
+    return out;
+}
+
+#endif
+
+std::vector<std::shared_ptr<AssetPack>> mountedPacks; // NOLINT
+std::mutex                              mountMutex;   // NOLINT
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+AssetPack::AssetPack(const char *file) : mapped(std::make_unique<MappedFile>(file))
+{
+    const auto *data = mapped->data();
+    const auto  size = mapped->size();
+
+    AssetPackHeader header;
+    if (size < sizeof(header)) throw packError("Truncated asset pack", file);
+    std::memcpy(&header, data, sizeof(header));
+
+    if (header.magic != AssetPackHeader::Magic) throw packError("Not an asset pack", file);
+    if (header.byteOrder != AssetPackHeader::ByteOrderMark) {
+        throw packError("Asset pack has foreign byte order", file);
+    }
+    if (header.version > AssetPackHeader::CurrentVersion) {
+        throw packError("Unsupported asset pack version", file);
+    }
+
+    const auto indexSize = std::uint64_t {header.numEntries} * sizeof(AssetPackEntry);
+    if (indexSize > size || header.indexOffset > size - indexSize || header.namesSize > size ||
+        header.namesOffset > size - header.namesSize) {
+        throw packError("Truncated asset pack", file);
+    }
+
+    entries.resize(header.numEntries);
+    std::memcpy(entries.data(), data + header.indexOffset, indexSize);
+    names = reinterpret_cast<const char *>(data + header.namesOffset);
+
+    for (const auto &e : entries) {
+        if (e.storedSize > size || e.offset > size - e.storedSize ||
+            e.nameLength > header.namesSize || e.nameOffset > header.namesSize - e.nameLength) {
+            throw packError("Invalid asset pack entry", file);
+        }
+    }
+}
+
+AssetPack::~AssetPack() = default;
+
+std::string_view AssetPack::nameOf(const AssetPackEntry &entry) const noexcept
+{
+    return {names + entry.nameOffset, entry.nameLength};
+}
+
+const AssetPackEntry *AssetPack::find(std::string_view name) const noexcept
+{
+    const auto it = std::lower_bound(
+        entries.begin(), entries.end(), name,
+        [this](const AssetPackEntry &e, std::string_view n) { return nameOf(e) < n; });
+    return it != entries.end() && nameOf(*it) == name ? &*it : nullptr;
+}
+
+bool AssetPack::contains(std::string_view name) const noexcept
+{
+    return find(name) != nullptr;
+}
+
+std::span<const std::byte> AssetPack::read(std::string_view name)
+{
+    const auto *entry = find(name);
+    if (entry == nullptr) return {};
+
+    const std::span<const std::byte> stored {mapped->data() + entry->offset,
+                                             static_cast<std::size_t>(entry->storedSize)};
+    if ((entry->flags & AssetPackEntry::Lz4) == 0) return stored;
+
+#ifdef SKY_WITH_LZ4
+    const std::scoped_lock lock {mutex};
+    const auto             key = static_cast<std::size_t>(entry - entries.data());
+    if (auto it = decompressed.find(key); it != decompressed.end()) return it->second;
+
+    std::vector<std::byte> contents(static_cast<std::size_t>(entry->size));
+    const auto             result = LZ4_decompress_safe(
+        reinterpret_cast<const char *>(stored.data()), reinterpret_cast<char *>(contents.data()),
+        static_cast<int>(stored.size()), static_cast<int>(contents.size()));
+    if (result < 0 || static_cast<std::size_t>(result) != contents.size()) {
+        throw packError("Corrupt asset pack entry", name);
+    }
+    return decompressed.emplace(key, std::move(contents)).first->second;
+#else
+    throw packError("Asset pack entry compressed, but built without SKY_WITH_LZ4", name);
+#endif
+}
+
+SDL_RWops *AssetPack::open(std::string_view name)
+{
+    const auto contents = read(name);
+    if (contents.data() == nullptr) return nullptr;
+    if (contents.size() > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+        throw packError("Asset pack entry too large", name);
+    }
+
+    auto *rw = SDL_RWFromConstMem(contents.data(), static_cast<int>(contents.size()));
+    if (rw == nullptr) throw packError("Open asset pack entry", name);
+    return rw;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AssetPack::mount(std::shared_ptr<AssetPack> pack)
+{
+    const std::scoped_lock lock {mountMutex};
+    mountedPacks.insert(mountedPacks.begin(), std::move(pack));
+}
+
+void AssetPack::unmountAll()
+{
+    const std::scoped_lock lock {mountMutex};
+    mountedPacks.clear();
+}
+
+SDL_RWops *AssetPack::openMounted(std::string_view path)
+{
+    const std::scoped_lock lock {mountMutex};
+    for (auto &pack : mountedPacks)
+        if (auto *rw = pack->open(path)) return rw;
+    return nullptr;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AssetPack::write(const char *packFile, std::vector<Source> sources, bool compressEntries)
+{
+#ifndef SKY_WITH_LZ4
+    if (compressEntries) {
+        throw std::runtime_error("Asset pack: compression needs a build with SKY_WITH_LZ4");
+    }
+#endif
+
+    std::sort(sources.begin(), sources.end(),
+              [](const Source &a, const Source &b) { return a.name < b.name; });
+    const auto duplicate = std::adjacent_find(
+        sources.begin(), sources.end(),
+        [](const Source &a, const Source &b) { return a.name == b.name; });
+    if (duplicate != sources.end()) throw packError("Duplicate asset pack entry", duplicate->name);
+
+    AssetPackHeader header;
+    header.numEntries = static_cast<std::uint32_t>(sources.size());
+    header.indexOffset = sizeof(AssetPackHeader);
+    header.namesOffset = header.indexOffset + sources.size() * sizeof(AssetPackEntry);
+
+    std::vector<AssetPackEntry> index(sources.size());
+    std::string                 namesBlock;
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        const auto &name = sources[i].name;
+        if (name.size() > std::numeric_limits<std::uint16_t>::max()) {
+            throw packError("Asset pack entry name too long", name);
+        }
+        index[i].nameOffset = static_cast<std::uint32_t>(namesBlock.size());
+        index[i].nameLength = static_cast<std::uint16_t>(name.size());
+        namesBlock += name;
+    }
+    header.namesSize = static_cast<std::uint32_t>(namesBlock.size());
+
+    std::ofstream out(packFile, std::ios::binary | std::ios::trunc);
+    if (!out) throw packError("Create asset pack", packFile);
+
+    // Entries are written after the index and names, so the index is filled in last
+    auto offset = alignUp(header.namesOffset + namesBlock.size());
+    out.seekp(static_cast<std::streamoff>(offset));
+    for (std::size_t i = 0; i < sources.size(); i++) {
+        auto data = readFile(sources[i].file);
+        index[i].size = data.size();
+
+#ifdef SKY_WITH_LZ4
+        if (compressEntries) {
+            if (auto packed = compress(data); !packed.empty()) {
+                data = std::move(packed);
+                index[i].flags |= AssetPackEntry::Lz4;
+            }
+        }
+#endif
+
+        index[i].offset = offset;
+        index[i].storedSize = data.size();
+        out.seekp(static_cast<std::streamoff>(offset));
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        offset = alignUp(offset + data.size());
+    }
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(index.data()),
+              static_cast<std::streamsize>(index.size() * sizeof(AssetPackEntry)));
+    out.write(namesBlock.data(), static_cast<std::streamsize>(namesBlock.size()));
+
+    if (!out) throw packError("Write asset pack", packFile);
+}
@@ -0,0 +1,118 @@
+#ifndef SKY_ASSETPACK_H_
+#define SKY_ASSETPACK_H_
+
+#include <SDL2/SDL.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sky
+{
+
+class MappedFile;
+
+/// @brief Header of an asset pack file, followed by the index, the names and the entries
+struct AssetPackHeader {
+    static constexpr std::uint32_t Magic = 0x4b504b53; // "SKPK"
+    static constexpr std::uint16_t CurrentVersion = 1;
+    static constexpr std::uint16_t ByteOrderMark = 0x0102;
+    static constexpr std::uint32_t Alignment = 16; ///< of the offset of every entry
+
+    std::uint32_t magic {Magic};
+    std::uint16_t version {CurrentVersion};
+    std::uint16_t byteOrder {ByteOrderMark};
+    std::uint32_t numEntries {0};
+    std::uint32_t namesSize {0};
+    std::uint64_t indexOffset {0};
+    std::uint64_t namesOffset {0};
+};
+
+/// @brief An index record of an asset pack; the index is sorted by name
+struct AssetPackEntry {
+    static constexpr std::uint16_t Lz4 = 1;
+
+    std::uint64_t offset {0};
+    std::uint64_t size {0};       ///< of the contents
+    std::uint64_t storedSize {0}; ///< in the file, differs from size if compressed
+    std::uint32_t nameOffset {0}; ///< in the names block
+    std::uint16_t nameLength {0};
+    std::uint16_t flags {0};
+};
+
+/**
+ * @brief An archive of asset files, read from memory
+ *
+ * The pack file is mapped into memory; entries are found by name with a binary search of
+ * the index, and handed to SDL as SDL_RWops reading the mapped pages, without copying.
+ * Entries compressed with LZ4 are decompressed on first use and kept until the pack is
+ * destroyed. Compressed entries need a build with the SKY_WITH_LZ4 option.
+ *
+ * Mounted packs are searched by Surface::fromFile() and Sky::loadFont(), so TextureRes,
+ * FontRes and SpriteRes load a path from a pack if one has it, and from disk otherwise.
+ * Keep a pack mounted while fonts loaded from it are in use, as they read it lazily.
+ *
+ * Thread-safe.
+ */
+class AssetPack
+{
+public:
+    /// @brief A file to pack, and its name in the pack
+    struct Source {
+        std::string name;
+        std::string file;
+    };
+
+    explicit AssetPack(const char *file);
+    ~AssetPack();
+
+    AssetPack(const AssetPack &) = delete;
+    AssetPack(AssetPack &&) = delete;
+    AssetPack &operator=(const AssetPack &) = delete;
+    AssetPack &operator=(AssetPack &&) = delete;
+
+    [[nodiscard]] std::size_t size() const noexcept { return entries.size(); }
+    [[nodiscard]] bool        contains(std::string_view name) const noexcept;
+
+    /// @brief Contents of an entry, empty if not found
+    [[nodiscard]] std::span<const std::byte> read(std::string_view name);
+
+    /// @brief A read-only SDL_RWops of an entry, nullptr if not found
+    [[nodiscard]] SDL_RWops *open(std::string_view name);
+
+    /// @brief Make the entries visible to resource loading, in front of packs mounted earlier
+    static void mount(std::shared_ptr<AssetPack> pack);
+    static void unmountAll();
+
+    /// @brief Open a path from the mounted packs, nullptr if none has it
+    [[nodiscard]] static SDL_RWops *openMounted(std::string_view path);
+
+    /**
+     * @brief Write a pack file
+     *
+     * @arg compress store entries compressed with LZ4, those that get smaller
+     */
+    static void write(const char *packFile, std::vector<Source> sources, bool compress = false);
+
+private:
+    std::unique_ptr<MappedFile> mapped;
+    std::vector<AssetPackEntry> entries;
+    const char                 *names {nullptr};
+
+    std::mutex                                              mutex;
+    std::unordered_map<std::size_t, std::vector<std::byte>> decompressed; ///< by entry index
+
+    [[nodiscard]] const AssetPackEntry *find(std::string_view name) const noexcept;
+    [[nodiscard]] std::string_view      nameOf(const AssetPackEntry &entry) const noexcept;
+};
+
+using SharedAssetPack = std::shared_ptr<AssetPack>;
+
+} // namespace sky
+
+#endif
@@ -0,0 +1,128 @@
+#include "Sky.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+using namespace sky;
+
+AssetStreamer::AssetStreamer(int threads)
+    : numThreads(threads > 0
+                     ? threads
+                     : std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1))
+{
+}
+
+AssetStreamer::~AssetStreamer()
+{
+    {
+        const std::scoped_lock lock {mutex};
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+AssetStreamer &AssetStreamer::shared()
+{
+    static AssetStreamer instance;
+    return instance;
+}
+
+SharedStreamJob AssetStreamer::submit(int priority, Decode decode, Upload upload)
+{
+    auto job = std::make_shared<StreamJob>();
+    job->priority = priority;
+    job->decode = std::move(decode);
+    job->upload = std::move(upload);
+
+    {
+        const std::scoped_lock lock {mutex};
+        if (workers.empty()) {
+            for (int i = 0; i < numThreads; i++)
+                workers.emplace_back([this]() { work(); });
+        }
+        queue.push({priority, sequence++, job});
+    }
+    pending++;
+    wake.notify_one();
+    return job;
+}
+
+void AssetStreamer::raise(const SharedStreamJob &job, int priority)
+{
+    const std::scoped_lock lock {mutex};
+    if (job->state.load() != StreamJob::Queued || priority <= job->priority) return;
+
+    // The old entry becomes stale and is skipped when popped
+    job->priority = priority;
+    queue.push({priority, sequence++, job});
+}
+
+void AssetStreamer::work()
+{
+    std::unique_lock lock {mutex};
+    while (true) {
+        wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+        if (stopping) return;
+
+        auto job = queue.top().job;
+        const auto isStale = queue.top().priority != job->priority;
+        queue.pop();
+        if (isStale || job->state.load() != StreamJob::Queued) continue;
+
+        job->state = StreamJob::Decoding;
+        lock.unlock();
+        try {
+            job->surface = job->decode();
+        } catch (...) {
+            job->error = std::current_exception();
+        }
+        job->decode = nullptr;
+        lock.lock();
+
+        job->state = StreamJob::Decoded;
+        decoded.push_back(std::move(job));
+    }
+}
+
+int AssetStreamer::pump()
+{
+    const auto start = SDL_GetPerformanceCounter();
+    const auto budget = static_cast<Uint64>(
+        uploadBudgetMs * static_cast<double>(SDL_GetPerformanceFrequency()) / 1000.0);
+
+    int uploaded = 0;
+    do {
+        SharedStreamJob job;
+        {
+            const std::scoped_lock lock {mutex};
+            if (decoded.empty()) break;
+
+            // Few jobs are decoded at a time, a linear search is enough
+            auto byPriority = [](const auto &a, const auto &b) {
+                return a->priority < b->priority;
+            };
+            const auto it = std::max_element(decoded.begin(), decoded.end(), byPriority);
+            job = std::move(*it);
+            decoded.erase(it);
+        }
+
+        try {
+            if (job->error) std::rethrow_exception(job->error);
+            job->upload(std::move(job->surface));
+            job->state = StreamJob::Done;
+        } catch (const std::exception &e) {
+            spdlog::error("Asset streaming: {}", e.what());
+            job->state = StreamJob::Failed;
+        }
+        job->upload = nullptr;
+        job->surface = Surface {nullptr};
+        job->error = nullptr;
+        pending--;
+        uploaded++;
+    } while (SDL_GetPerformanceCounter() - start < budget);
+
+    return uploaded;
+}
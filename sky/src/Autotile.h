@@ -0,0 +1,205 @@
+#ifndef SKY_AUTOTILE_H_
+#define SKY_AUTOTILE_H_
+
+#include "Tiles.h"
+
+#include <mist/Point.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace sky
+{
+
+/// @brief Neighbor bits used in autotile masks
+struct AutotileBits {
+    // 4-neighbor masks
+    static constexpr int North = 1;
+    static constexpr int East = 2;
+    static constexpr int South = 4;
+    static constexpr int West = 8;
+
+    // 8-neighbor masks
+    static constexpr int N = 1;
+    static constexpr int NE = 2;
+    static constexpr int E = 4;
+    static constexpr int SE = 8;
+    static constexpr int S = 16;
+    static constexpr int SW = 32;
+    static constexpr int W = 64;
+    static constexpr int NW = 128;
+
+    /**
+     * @brief Clear corner bits whose adjacent edges are not both set
+     *
+     * Such corners do not change the look of a blob tile, so this reduces the 256 possible
+     * 8-neighbor masks to the 47 distinct blob tiles.
+     */
+    static constexpr int reduceCorners(int mask)
+    {
+        if ((mask & N) == 0 || (mask & E) == 0) mask &= ~NE;
+        if ((mask & S) == 0 || (mask & E) == 0) mask &= ~SE;
+        if ((mask & S) == 0 || (mask & W) == 0) mask &= ~SW;
+        if ((mask & N) == 0 || (mask & W) == 0) mask &= ~NW;
+        return mask;
+    }
+
+    static constexpr int NumBlobTiles = 47;
+};
+
+/**
+ * @brief Bitmask autotiling from a terrain layer to a visual layer of a TileMap
+ *
+ * The terrain layer holds terrain types. For every cell with a terrain rule, the visual layer
+ * gets the tile selected by a bitmask of neighbors with the same terrain, using either 4 or 8
+ * neighbors. With 8 neighbors, corners are reduced with AutotileBits::reduceCorners(), so a
+ * rule has one tile per blob tile instead of one per mask. Cells outside the map count as the
+ * same terrain. Cells without a rule get the
+ * default tile, Empty unless set with setDefaultTile().
+ *
+ * Edit terrain through setTerrain(): it only recomputes the edited cell and its neighbors,
+ * and reports the changed area to the change listener, so render caches can be updated.
+ */
+template <class Cell> class Autotiler
+{
+public:
+    enum class Mode { FourNeighbors, EightNeighbors };
+
+    using Map = BasicTileMap<Cell>;
+    using TileTable = std::vector<Cell>;
+    /// @brief Receives the changed area, in tiles
+    using ChangeListener = std::function<void(const SDL_Rect &tiles)>;
+
+    Autotiler(std::shared_ptr<Map> map_, int terrainLayer_, int visualLayer_, Mode mode_)
+        : map(std::move(map_)), terrainLayer(terrainLayer_), visualLayer(visualLayer_), mode(mode_)
+    {
+    }
+
+    /// @brief Number of tiles in a rule: 16 masks, or 47 blob tiles with 8 neighbors
+    [[nodiscard]] int getRuleSize() const noexcept
+    {
+        return mode == Mode::FourNeighbors ? 16 : AutotileBits::NumBlobTiles;
+    }
+
+    /**
+     * @brief Define tiles for a terrain type
+     *
+     * @arg tiles visual tile for every mask with 4 neighbors; with 8 neighbors, for every
+     * reduced mask, in ascending order of the masks
+     */
+    void setRule(Cell terrain, TileTable tiles)
+    {
+        if (static_cast<int>(tiles.size()) != getRuleSize()) {
+            throw std::runtime_error("Autotile rule: wrong number of tiles");
+        }
+        const auto index = static_cast<std::size_t>(terrain);
+        if (index >= rules.size()) rules.resize(index + 1);
+        rules[index] = std::move(tiles);
+    }
+
+    /// @brief Rule for tilesets with one tile per mask, in mask order, starting at firstTile
+    void setSequentialRule(Cell terrain, Cell firstTile)
+    {
+        TileTable tiles(static_cast<std::size_t>(getRuleSize()));
+        for (std::size_t mask = 0; mask < tiles.size(); mask++)
+            tiles[mask] = static_cast<Cell>(firstTile + mask);
+        setRule(terrain, std::move(tiles));
+    }
+
+    /// @brief Visual tile for cells whose terrain has no rule
+    void setDefaultTile(Cell tile) noexcept { defaultTile = tile; }
+
+    void setChangeListener(ChangeListener listener) { onChange = std::move(listener); }
+
+    [[nodiscard]] Cell getTerrain(const mist::Point2i &p) const { return map->at(terrainLayer, p); }
+
+    void setTerrain(const mist::Point2i &p, Cell terrain)
+    {
+        map->at(terrainLayer, p) = terrain;
+
+        const auto x0 = std::max(0, p.x - 1);
+        const auto y0 = std::max(0, p.y - 1);
+        const auto x1 = std::min(map->getWidth() - 1, p.x + 1);
+        const auto y1 = std::min(map->getHeight() - 1, p.y + 1);
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+                updateCell({x, y});
+
+        if (onChange) onChange(SDL_Rect {x0, y0, x1 - x0 + 1, y1 - y0 + 1});
+    }
+
+    /// @brief Recompute the whole visual layer, e.g. after loading a map
+    void rebuild()
+    {
+        for (int y = 0; y < map->getHeight(); y++)
+            for (int x = 0; x < map->getWidth(); x++)
+                updateCell({x, y});
+
+        if (onChange) onChange(SDL_Rect {0, 0, map->getWidth(), map->getHeight()});
+    }
+
+    /// @brief Mask of neighbors with the same terrain; corners reduced with 8 neighbors
+    [[nodiscard]] int maskAt(const mist::Point2i &p) const
+    {
+        const auto terrain = getTerrain(p);
+        auto       same = [&](int dx, int dy) {
+            const mist::Point2i n {p.x + dx, p.y + dy};
+            if (n.x < 0 || n.y < 0 || n.x >= map->getWidth() || n.y >= map->getHeight())
+                return true;
+            return map->at(terrainLayer, n) == terrain;
+        };
+
+        using B = AutotileBits;
+        if (mode == Mode::FourNeighbors) {
+            return (same(0, -1) ? B::North : 0) | (same(1, 0) ? B::East : 0) |
+                   (same(0, 1) ? B::South : 0) | (same(-1, 0) ? B::West : 0);
+        }
+        return B::reduceCorners(
+            (same(0, -1) ? B::N : 0) | (same(1, -1) ? B::NE : 0) | (same(1, 0) ? B::E : 0) |
+            (same(1, 1) ? B::SE : 0) | (same(0, 1) ? B::S : 0) | (same(-1, 1) ? B::SW : 0) |
+            (same(-1, 0) ? B::W : 0) | (same(-1, -1) ? B::NW : 0));
+    }
+
+private:
+    /// Blob tile of every reduced 8-neighbor mask, in ascending mask order
+    static constexpr std::array<std::uint8_t, 256> blobTiles = [] {
+        std::array<std::uint8_t, 256> table {};
+        std::uint8_t                  next = 0;
+        for (int mask = 0; mask < 256; mask++) {
+            if (AutotileBits::reduceCorners(mask) == mask)
+                table[static_cast<std::size_t>(mask)] = next++;
+        }
+        return table;
+    }();
+    static_assert(blobTiles[255] == AutotileBits::NumBlobTiles - 1);
+
+    std::shared_ptr<Map>   map;
+    const int              terrainLayer;
+    const int              visualLayer;
+    const Mode             mode;
+    std::vector<TileTable> rules;
+    Cell                   defaultTile {Map::Empty};
+    ChangeListener         onChange;
+
+    void updateCell(const mist::Point2i &p)
+    {
+        const auto terrain = static_cast<std::size_t>(getTerrain(p));
+        auto      &visual = map->at(visualLayer, p);
+        if (terrain >= rules.size() || rules[terrain].empty()) {
+            visual = defaultTile;
+            return;
+        }
+
+        const auto mask = static_cast<std::size_t>(maskAt(p));
+        visual = rules[terrain][mode == Mode::FourNeighbors ? mask : blobTiles[mask]];
+    }
+};
+
+} // namespace sky
+
+#endif
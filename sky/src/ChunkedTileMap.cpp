@@ -0,0 +1,312 @@
+#include "ChunkedTileMap.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+using namespace sky;
+
+namespace
+{
+
+int floorDiv(int a, int b)
+{
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)) ? 1 : 0);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+ChunkDirectory::ChunkDirectory(std::string directory_, Generator generator_)
+    : directory(std::move(directory_)), generator(std::move(generator_))
+{
+}
+
+std::string ChunkDirectory::pathOf(const mist::Point2i &pos) const
+{
+    return directory + "/" + std::to_string(pos.x) + "_" + std::to_string(pos.y) + ".chunk";
+}
+
+void ChunkDirectory::load(const mist::Point2i &pos, std::span<Cell> cells)
+{
+    std::ifstream file(pathOf(pos), std::ios::binary);
+    if (!file) {
+        if (generator)
+            generator(pos, cells);
+        else
+            std::fill(cells.begin(), cells.end(), TileMap::Empty);
+        return;
+    }
+
+    file.read(reinterpret_cast<char *>(cells.data()),
+              static_cast<std::streamsize>(cells.size_bytes()));
+    if (!file) throw std::runtime_error("Load chunk: truncated file " + pathOf(pos));
+}
+
+void ChunkDirectory::store(const mist::Point2i &pos, std::span<const Cell> cells)
+{
+    std::ofstream file(pathOf(pos), std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(cells.data()),
+               static_cast<std::streamsize>(cells.size_bytes()));
+    if (!file) throw std::runtime_error("Store chunk: cannot write " + pathOf(pos));
+}
+
+/* -------------------------------------------------------------------------- */
+
+ChunkedTileMap::ChunkedTileMap(SharedTileset tileset_, std::shared_ptr<ChunkSource> source_,
+                               int chunkSize_, int numThreads)
+    : tileset(std::move(tileset_)), source(std::move(source_)), chunkSize(chunkSize_)
+{
+    if (chunkSize <= 0) throw std::runtime_error("Chunked tile map: invalid chunk size");
+
+    for (int i = 0; i < std::max(1, numThreads); i++)
+        workers.emplace_back([this] { workerLoop(); });
+}
+
+ChunkedTileMap::~ChunkedTileMap()
+{
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+    for (auto &t : workers)
+        t.join();
+
+    // Workers finish all pending stores before exiting, only loaded chunks are left
+    try {
+        flush();
+    } catch (std::exception &e) {
+        spdlog::error("Chunked tile map: {}", e.what());
+    }
+}
+
+ChunkedTileMap::Key ChunkedTileMap::keyOf(const mist::Point2i &chunkPos) noexcept
+{
+    return (static_cast<Key>(static_cast<std::uint32_t>(chunkPos.x)) << 32u) |
+           static_cast<std::uint32_t>(chunkPos.y);
+}
+
+mist::Point2i ChunkedTileMap::chunkOf(const mist::Point2i &tile) const noexcept
+{
+    return {floorDiv(tile.x, chunkSize), floorDiv(tile.y, chunkSize)};
+}
+
+std::size_t ChunkedTileMap::cellIndex(const mist::Point2i &tile) const noexcept
+{
+    const auto chunk = chunkOf(tile);
+    const auto lx = tile.x - chunk.x * chunkSize;
+    const auto ly = tile.y - chunk.y * chunkSize;
+    return static_cast<std::size_t>(ly * chunkSize + lx);
+}
+
+std::size_t ChunkedTileMap::chunkBytes() const noexcept
+{
+    return static_cast<std::size_t>(chunkSize * chunkSize) * sizeof(Cell);
+}
+
+std::size_t ChunkedTileMap::getMemoryUsage() const noexcept
+{
+    return chunks.size() * chunkBytes();
+}
+
+bool ChunkedTileMap::isLoaded(const mist::Point2i &tile) const
+{
+    return chunks.contains(keyOf(chunkOf(tile)));
+}
+
+ChunkedTileMap::Cell ChunkedTileMap::at(const mist::Point2i &tile) const
+{
+    auto it = chunks.find(keyOf(chunkOf(tile)));
+    if (it == chunks.end()) return Empty;
+    return it->second.cells[cellIndex(tile)];
+}
+
+bool ChunkedTileMap::set(const mist::Point2i &tile, Cell value)
+{
+    auto it = chunks.find(keyOf(chunkOf(tile)));
+    if (it == chunks.end()) return false;
+
+    it->second.cells[cellIndex(tile)] = value;
+    it->second.dirty = true;
+    return true;
+}
+
+void ChunkedTileMap::update()
+{
+    frame++;
+    integrateResults();
+    requestChunksInRange();
+    evict();
+}
+
+void ChunkedTileMap::flush()
+{
+    for (auto &[key, chunk] : chunks) {
+        if (!chunk.dirty) continue;
+        source->store(chunk.pos, chunk.cells);
+        chunk.dirty = false;
+    }
+}
+
+std::vector<ChunkedTileMap::Cell> ChunkedTileMap::takeBuffer()
+{
+    if (spareBuffers.empty()) {
+        return std::vector<Cell>(static_cast<std::size_t>(chunkSize * chunkSize));
+    }
+
+    auto buffer = std::move(spareBuffers.back());
+    spareBuffers.pop_back();
+    return buffer;
+}
+
+void ChunkedTileMap::integrateResults()
+{
+    {
+        std::lock_guard lock(mutex);
+        std::swap(results, completed);
+    }
+
+    for (auto &job : completed) {
+        const auto key = keyOf(job.pos);
+        if (job.type == Job::Type::Load) {
+            pendingLoads.erase(key);
+            chunks.emplace(key, Chunk {job.pos, std::move(job.cells), frame, false});
+        } else {
+            pendingStores.erase(key);
+            spareBuffers.emplace_back(std::move(job.cells));
+        }
+    }
+    completed.clear();
+}
+
+void ChunkedTileMap::requestChunksInRange()
+{
+    const auto center = chunkOf(focus);
+
+    // Walk rings of increasing distance, so that the nearest chunks are queued first
+    for (int d = 0; d <= loadRadius; d++) {
+        for (int dy = -d; dy <= d; dy++) {
+            for (int dx = -d; dx <= d; dx++) {
+                if (std::max(std::abs(dx), std::abs(dy)) != d) continue;
+
+                const mist::Point2i pos {center.x + dx, center.y + dy};
+                const auto          key = keyOf(pos);
+
+                if (auto it = chunks.find(key); it != chunks.end()) {
+                    it->second.lastUsed = frame;
+                    continue;
+                }
+                if (pendingLoads.contains(key) || pendingStores.contains(key)) continue;
+
+                pendingLoads.insert(key);
+                post(Job {Job::Type::Load, pos, takeBuffer()});
+            }
+        }
+    }
+}
+
+void ChunkedTileMap::evict()
+{
+    while (getMemoryUsage() > memoryBudget) {
+        auto lru = chunks.end();
+        for (auto it = chunks.begin(); it != chunks.end(); ++it) {
+            if (it->second.lastUsed == frame) continue;
+            if (lru == chunks.end() || it->second.lastUsed < lru->second.lastUsed) lru = it;
+        }
+        // Everything left is in range of the focus point
+        if (lru == chunks.end()) break;
+
+        auto &chunk = lru->second;
+        if (chunk.dirty) {
+            pendingStores.insert(lru->first);
+            post(Job {Job::Type::Store, chunk.pos, std::move(chunk.cells)});
+        } else {
+            spareBuffers.emplace_back(std::move(chunk.cells));
+        }
+        chunks.erase(lru);
+    }
+}
+
+void ChunkedTileMap::post(Job job)
+{
+    {
+        std::lock_guard lock(mutex);
+        jobs.emplace_back(std::move(job));
+    }
+    jobAvailable.notify_one();
+}
+
+void ChunkedTileMap::workerLoop()
+{
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock lock(mutex);
+            jobAvailable.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) return;
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            // Loads are pointless once shutting down, but stores must not be lost
+            if (stopping && job.type == Job::Type::Load) continue;
+        }
+
+        try {
+            if (job.type == Job::Type::Load)
+                source->load(job.pos, job.cells);
+            else
+                source->store(job.pos, job.cells);
+        } catch (std::exception &e) {
+            spdlog::error("Chunked tile map: {}", e.what());
+            if (job.type == Job::Type::Load) std::fill(job.cells.begin(), job.cells.end(), Empty);
+        }
+
+        std::lock_guard lock(mutex);
+        results.emplace_back(std::move(job));
+    }
+}
+
+void ChunkedTileMap::draw(Renderer &renderer, int x, int y, double)
+{
+    const auto tileSize = tileset->getTileSize();
+    int        screenWidth = 0;
+    int        screenHeight = 0;
+    SDL_GetRendererOutputSize(renderer, &screenWidth, &screenHeight);
+
+    // Visible tile range; x, y is the screen position of tile (0, 0)
+    const mist::Point2i first {floorDiv(-x, tileSize), floorDiv(-y, tileSize)};
+    const mist::Point2i last {floorDiv(screenWidth - x - 1, tileSize),
+                              floorDiv(screenHeight - y - 1, tileSize)};
+    const auto          firstChunk = chunkOf(first);
+    const auto          lastChunk = chunkOf(last);
+
+    SDL_Rect destRect {0, 0, tileSize, tileSize};
+
+    for (int cy = firstChunk.y; cy <= lastChunk.y; cy++) {
+        for (int cx = firstChunk.x; cx <= lastChunk.x; cx++) {
+            auto it = chunks.find(keyOf({cx, cy}));
+            if (it == chunks.end()) continue;
+
+            const auto &cells = it->second.cells;
+            const auto  x0 = std::max(first.x, cx * chunkSize);
+            const auto  x1 = std::min(last.x, (cx + 1) * chunkSize - 1);
+            const auto  y0 = std::max(first.y, cy * chunkSize);
+            const auto  y1 = std::min(last.y, (cy + 1) * chunkSize - 1);
+
+            for (int ty = y0; ty <= y1; ty++) {
+                for (int tx = x0; tx <= x1; tx++) {
+                    const auto cell = cells[cellIndex({tx, ty})];
+                    if (cell == Empty) continue;
+                    destRect.x = x + tx * tileSize;
+                    destRect.y = y + ty * tileSize;
+                    tileset->drawTile(renderer, tileset->resolveTile(cell), destRect);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,178 @@
+#ifndef SKY_CHUNKEDTILEMAP_H_
+#define SKY_CHUNKEDTILEMAP_H_
+
+#include "SkyEngine.h"
+#include "Tiles.h"
+
+#include <mist/Point.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace sky
+{
+
+/**
+ * @brief Provides chunk contents for a ChunkedTileMap
+ *
+ * Both functions are called from worker threads, possibly concurrently for different chunks.
+ * A chunk is never loaded while a store of the same chunk is still in progress.
+ */
+class ChunkSource
+{
+public:
+    using Cell = TileMap::CellType;
+
+    ChunkSource() = default;
+    ChunkSource(const ChunkSource &) = delete;
+    ChunkSource(ChunkSource &&) = delete;
+    ChunkSource &operator=(const ChunkSource &) = delete;
+    ChunkSource &operator=(ChunkSource &&) = delete;
+    virtual ~ChunkSource() = default;
+
+    /// @brief Fill cells of the chunk at chunk coordinates pos, in row-major order
+    virtual void load(const mist::Point2i &pos, std::span<Cell> cells) = 0;
+
+    /// @brief Write back a modified chunk; the default implementation discards changes
+    virtual void store(const mist::Point2i &, std::span<const Cell>) {}
+};
+
+/**
+ * @brief ChunkSource keeping one file per chunk in a directory
+ *
+ * Chunks that have no file yet are produced by the generator function.
+ */
+class ChunkDirectory : public ChunkSource
+{
+public:
+    using Generator = std::function<void(const mist::Point2i &pos, std::span<Cell> cells)>;
+
+    ChunkDirectory(std::string directory, Generator generator);
+
+    void load(const mist::Point2i &pos, std::span<Cell> cells) override;
+    void store(const mist::Point2i &pos, std::span<const Cell> cells) override;
+
+private:
+    std::string directory;
+    Generator   generator;
+
+    [[nodiscard]] std::string pathOf(const mist::Point2i &pos) const;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief An unbounded Drawable tile map, paged in fixed-size chunks
+ *
+ * Only chunks around the focus point are kept in memory. Call update() once per frame on the
+ * main thread: it integrates chunks loaded by worker threads, requests chunks that came into
+ * range and evicts least recently used chunks once the memory budget is exceeded. Modified
+ * chunks are written back to the ChunkSource when evicted and on destruction.
+ *
+ * Tile coordinates may be negative. Cells of chunks that are not loaded read as Empty.
+ */
+class ChunkedTileMap : public Drawable
+{
+public:
+    using Cell = TileMap::CellType;
+    static constexpr Cell Empty = TileMap::Empty;
+
+    ChunkedTileMap(SharedTileset tileset, std::shared_ptr<ChunkSource> source,
+                   int chunkSize = 32, int numThreads = 2);
+    ~ChunkedTileMap() override;
+
+    ChunkedTileMap(const ChunkedTileMap &) = delete;
+    ChunkedTileMap(ChunkedTileMap &&) = delete;
+    ChunkedTileMap &operator=(const ChunkedTileMap &) = delete;
+    ChunkedTileMap &operator=(ChunkedTileMap &&) = delete;
+
+    [[nodiscard]] int getChunkSize() const noexcept { return chunkSize; }
+    [[nodiscard]] int getTileSize() const noexcept { return tileset->getTileSize(); }
+
+    /// @brief Tile position around which chunks are kept loaded
+    void setFocus(const mist::Point2i &tile) noexcept { focus = tile; }
+    /// @brief Distance from the focus, in chunks, within which chunks are requested
+    void setLoadRadius(int radius) noexcept { loadRadius = radius; }
+    void setMemoryBudget(std::size_t bytes) noexcept { memoryBudget = bytes; }
+
+    [[nodiscard]] std::size_t getMemoryUsage() const noexcept;
+    [[nodiscard]] std::size_t getNumLoadedChunks() const noexcept { return chunks.size(); }
+    [[nodiscard]] bool        isLoaded(const mist::Point2i &tile) const;
+
+    [[nodiscard]] Cell at(const mist::Point2i &tile) const;
+    /// @brief Change a cell and mark its chunk dirty; returns false if the chunk is not loaded
+    bool set(const mist::Point2i &tile, Cell value);
+
+    void update();
+    void flush();
+
+    void draw(Renderer &renderer, int x, int y, double) override;
+
+private:
+    using Key = std::uint64_t;
+
+    struct Chunk {
+        mist::Point2i     pos;
+        std::vector<Cell> cells;
+        std::uint64_t     lastUsed {0};
+        bool              dirty {false};
+    };
+
+    struct Job {
+        enum class Type { Load, Store };
+        Type              type;
+        mist::Point2i     pos;
+        std::vector<Cell> cells;
+    };
+
+    SharedTileset                tileset;
+    std::shared_ptr<ChunkSource> source;
+    const int                    chunkSize;
+
+    mist::Point2i focus {0, 0};
+    int           loadRadius {2};
+    std::size_t   memoryBudget {64u << 20u};
+    std::uint64_t frame {0};
+
+    std::unordered_map<Key, Chunk> chunks;
+    std::unordered_set<Key>        pendingLoads;
+    std::unordered_set<Key>        pendingStores;
+    std::vector<std::vector<Cell>> spareBuffers;
+
+    std::mutex               mutex;
+    std::condition_variable  jobAvailable;
+    std::deque<Job>          jobs;
+    std::vector<Job>         results;
+    std::vector<Job>         completed;
+    std::vector<std::thread> workers;
+    bool                     stopping {false};
+
+    static Key keyOf(const mist::Point2i &chunkPos) noexcept;
+
+    [[nodiscard]] mist::Point2i chunkOf(const mist::Point2i &tile) const noexcept;
+    [[nodiscard]] std::size_t   cellIndex(const mist::Point2i &tile) const noexcept;
+    [[nodiscard]] std::size_t   chunkBytes() const noexcept;
+
+    std::vector<Cell> takeBuffer();
+    void              integrateResults();
+    void              requestChunksInRange();
+    void              evict();
+    void              post(Job job);
+    void              workerLoop();
+};
+
+using SharedChunkedTileMap = std::shared_ptr<ChunkedTileMap>;
+
+} // namespace sky
+
+#endif
@@ -0,0 +1,156 @@
+#include "Collision.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace sky;
+
+namespace
+{
+
+bool boxVsCircle(mist::Point2d boxPos, mist::Point2d halfExtents, mist::Point2d circlePos,
+                 double radius)
+{
+    const auto closestX =
+        std::clamp(circlePos.x, boxPos.x - halfExtents.x, boxPos.x + halfExtents.x);
+    const auto closestY =
+        std::clamp(circlePos.y, boxPos.y - halfExtents.y, boxPos.y + halfExtents.y);
+    const auto dx = circlePos.x - closestX;
+    const auto dy = circlePos.y - closestY;
+    return dx * dx + dy * dy <= radius * radius;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void CollisionWorld::add(SharedObject object, const Shape &shape)
+{
+    order.push_back(bodies.size());
+    bodies.emplace_back(Body {std::move(object), shape, {}});
+}
+
+void CollisionWorld::remove(const Object *object)
+{
+    auto it = std::find_if(bodies.begin(), bodies.end(),
+                           [=](const Body &b) { return b.object.get() == object; });
+    if (it == bodies.end()) return;
+
+    const auto removed = static_cast<std::size_t>(it - bodies.begin());
+    const auto last = bodies.size() - 1;
+    if (removed != last) *it = std::move(bodies.back());
+    bodies.pop_back();
+
+    // Keep the sort order, only the entry of the moved body gets a new index
+    order.erase(std::find(order.begin(), order.end(), removed));
+    for (auto &i : order)
+        if (i == last) i = removed;
+}
+
+void CollisionWorld::clear()
+{
+    bodies.clear();
+    order.clear();
+    contacts.clear();
+    tileContacts.clear();
+}
+
+void CollisionWorld::step()
+{
+    updateBounds();
+    sortAxis();
+    findContacts();
+    findTileContacts();
+}
+
+bool CollisionWorld::intersects(const Shape &a, mist::Point2d posA, const Shape &b,
+                                mist::Point2d posB)
+{
+    using T = Shape::Type;
+
+    if (a.type == T::Aabb && b.type == T::Aabb) {
+        return std::abs(posA.x - posB.x) <= a.halfExtents.x + b.halfExtents.x &&
+               std::abs(posA.y - posB.y) <= a.halfExtents.y + b.halfExtents.y;
+    }
+    if (a.type == T::Circle && b.type == T::Circle) {
+        const auto dx = posA.x - posB.x;
+        const auto dy = posA.y - posB.y;
+        const auto r = a.halfExtents.x + b.halfExtents.x;
+        return dx * dx + dy * dy <= r * r;
+    }
+    if (a.type == T::Aabb) return boxVsCircle(posA, a.halfExtents, posB, b.halfExtents.x);
+    return boxVsCircle(posB, b.halfExtents, posA, a.halfExtents.x);
+}
+
+void CollisionWorld::updateBounds()
+{
+    for (auto &b : bodies) {
+        const auto &p = b.object->position;
+        const auto &e = b.shape.halfExtents;
+        b.bounds = {{p.x - e.x, p.y - e.y}, {p.x + e.x, p.y + e.y}};
+    }
+}
+
+void CollisionWorld::sortAxis()
+{
+    // Insertion sort: the order from the previous step is nearly sorted already
+    for (std::size_t i = 1; i < order.size(); i++) {
+        const auto  idx = order[i];
+        const auto  key = bodies[idx].bounds.min.x;
+        std::size_t j = i;
+        while (j > 0 && bodies[order[j - 1]].bounds.min.x > key) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = idx;
+    }
+}
+
+void CollisionWorld::findContacts()
+{
+    contacts.clear();
+
+    for (std::size_t i = 0; i < order.size(); i++) {
+        const auto &a = bodies[order[i]];
+
+        for (std::size_t j = i + 1; j < order.size(); j++) {
+            const auto &b = bodies[order[j]];
+            if (b.bounds.min.x > a.bounds.max.x) break;
+            if (!a.bounds.overlaps(b.bounds)) continue;
+            if (!intersects(a.shape, a.object->position, b.shape, b.object->position)) continue;
+
+            contacts.emplace_back(Contact {a.object.get(), b.object.get()});
+        }
+    }
+}
+
+void CollisionWorld::findTileContacts()
+{
+    tileContacts.clear();
+    if (!solidAt) return;
+
+    const auto  maxX = tileMapSize.x - 1;
+    const auto  maxY = tileMapSize.y - 1;
+    const Shape tileShape = Shape::aabb(1.0, 1.0);
+
+    for (const auto &b : bodies) {
+        const auto x0 = std::max(0, static_cast<int>(std::floor(b.bounds.min.x - tileMapOrigin.x)));
+        const auto y0 = std::max(0, static_cast<int>(std::floor(b.bounds.min.y - tileMapOrigin.y)));
+        const auto x1 =
+            std::min(maxX, static_cast<int>(std::floor(b.bounds.max.x - tileMapOrigin.x)));
+        const auto y1 =
+            std::min(maxY, static_cast<int>(std::floor(b.bounds.max.y - tileMapOrigin.y)));
+
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                if (!solidAt({x, y})) continue;
+
+                const mist::Point2d tileCenter {tileMapOrigin.x + x + 0.5,
+                                                tileMapOrigin.y + y + 0.5};
+                if (!intersects(b.shape, b.object->position, tileShape, tileCenter)) continue;
+
+                tileContacts.emplace_back(TileContact {b.object.get(), {x, y}});
+            }
+        }
+    }
+}
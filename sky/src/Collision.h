@@ -0,0 +1,140 @@
+#ifndef SKY_COLLISION_H_
+#define SKY_COLLISION_H_
+
+#include "SkyEngine.h"
+#include "Tiles.h"
+
+#include <mist/Point.h>
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace sky
+{
+
+/// @brief Axis-aligned box in world coordinates
+struct Bounds {
+    mist::Point2d min;
+    mist::Point2d max;
+
+    [[nodiscard]] bool overlaps(const Bounds &other) const noexcept
+    {
+        return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y &&
+               other.min.y <= max.y;
+    }
+};
+
+/// @brief Collision shape, centered on the Object position
+struct Shape {
+    enum class Type { Aabb, Circle };
+
+    Type          type {Type::Aabb};
+    mist::Point2d halfExtents {0, 0}; ///< for circles, both components hold the radius
+
+    static Shape aabb(double width, double height) { return {Type::Aabb, {width / 2, height / 2}}; }
+    static Shape circle(double radius) { return {Type::Circle, {radius, radius}}; }
+};
+
+struct Contact {
+    Object *a;
+    Object *b;
+};
+
+struct TileContact {
+    Object       *object;
+    mist::Point2i tile;
+};
+
+/**
+ * @brief Broadphase + narrowphase collision detection for Objects
+ *
+ * Shapes are attached to Objects with add(). Each step() refreshes their bounds from the
+ * current Object positions and finds overlapping pairs with sweep-and-prune along the X axis.
+ * The sort order is kept between steps and repaired with an insertion sort, which is close
+ * to linear when objects move coherently.
+ *
+ * Contacts are written to internal vectors which are cleared, not reallocated, on every step,
+ * so there are no per-frame allocations once the vectors have grown to the working size.
+ *
+ * Optionally, objects are also tested against solid tiles of a TileMap, see setTileMap().
+ */
+class CollisionWorld
+{
+public:
+    using SolidPredicate = std::function<bool(int tileId)>;
+
+    CollisionWorld() = default;
+
+    void add(SharedObject object, const Shape &shape);
+    void remove(const Object *object);
+    void clear();
+
+    [[nodiscard]] std::size_t size() const noexcept { return bodies.size(); }
+
+    /**
+     * @brief Enable tile-vs-object tests against a TileMap
+     *
+     * The map is assumed to be placed at origin in world coordinates, with one world unit
+     * per tile (as set up by Transforms::tiles()).
+     *
+     * @arg map tile map to test against, or nullptr to disable tile tests
+     * @arg isSolid returns true for tile ids that objects collide with
+     * @arg origin world position of the top-left corner of the map
+     * @arg layer map layer holding the tiles to test
+     */
+    template <class Cell>
+    void setTileMap(std::shared_ptr<BasicTileMap<Cell>> map, SolidPredicate isSolid,
+                    mist::Point2d origin = {0, 0}, int layer = 0)
+    {
+        tileMapOrigin = origin;
+        if (map == nullptr || !isSolid) {
+            solidAt = nullptr;
+            return;
+        }
+
+        tileMapSize = {map->getWidth(), map->getHeight()};
+        solidAt = [map = std::move(map), isSolid = std::move(isSolid),
+                   layer](const mist::Point2i &p) {
+            const auto tile = map->at(layer, p);
+            return tile != BasicTileMap<Cell>::Empty && isSolid(static_cast<int>(tile));
+        };
+    }
+
+    void step();
+
+    [[nodiscard]] const std::vector<Contact>     &getContacts() const noexcept { return contacts; }
+    [[nodiscard]] const std::vector<TileContact> &getTileContacts() const noexcept
+    {
+        return tileContacts;
+    }
+
+    static bool intersects(const Shape &a, mist::Point2d posA, const Shape &b,
+                           mist::Point2d posB);
+
+private:
+    struct Body {
+        SharedObject object;
+        Shape        shape;
+        Bounds       bounds;
+    };
+
+    std::vector<Body>        bodies;
+    std::vector<std::size_t> order;
+
+    std::vector<Contact>     contacts;
+    std::vector<TileContact> tileContacts;
+
+    std::function<bool(const mist::Point2i &)> solidAt;
+    mist::Point2i                              tileMapSize {0, 0};
+    mist::Point2d                              tileMapOrigin {0, 0};
+
+    void updateBounds();
+    void sortAxis();
+    void findContacts();
+    void findTileContacts();
+};
+
+} // namespace sky
+
+#endif
@@ -74,7 +74,9 @@ auto HSVRamp::to(const HSV &color) -> HSVRamp &
 
 auto HSVRamp::build() const -> void
 {
-    indexToColor = [&](int i) {
+    // Capture by value, so that copies of the ramp (e.g. inside copied tile painters) are
+    // independent of each other
+    indexToColor = [numSteps = numSteps, startValues = startValues, endValues = endValues](int i) {
         const auto progress = static_cast<float>(i) / static_cast<float>(numSteps - 1);
         const auto hue = mist::lerp(progress, startValues.hue, endValues.hue);
         const auto sat = mist::lerp(progress, startValues.sat, endValues.sat);
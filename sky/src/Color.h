@@ -59,10 +59,14 @@ public:
     auto get(int i) const -> Color;
     auto asFunc() const -> IndexToColor;
 
+    [[nodiscard]] int        getNumSteps() const noexcept { return numSteps; }
+    [[nodiscard]] const HSV &getFrom() const noexcept { return startValues; }
+    [[nodiscard]] const HSV &getTo() const noexcept { return endValues; }
+
 private:
     int numSteps;
-    HSV startValues;
-    HSV endValues;
+    HSV startValues {};
+    HSV endValues {};
 
     mutable IndexToColor indexToColor {nullptr};
     auto                 build() const -> void;
@@ -0,0 +1,672 @@
+#include "Pathfinding.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+using namespace sky;
+
+namespace
+{
+
+constexpr float Diagonal = 1.41421356f;
+constexpr float Infinity = std::numeric_limits<float>::infinity();
+
+constexpr int Directions[8][2] = {{1, 0},  {-1, 0}, {0, 1},  {0, -1},
+                                  {1, 1},  {1, -1}, {-1, 1}, {-1, -1}};
+
+float octile(int dx, int dy)
+{
+    dx = std::abs(dx);
+    dy = std::abs(dy);
+    return static_cast<float>(std::max(dx, dy)) +
+           (Diagonal - 1.0f) * static_cast<float>(std::min(dx, dy));
+}
+
+int sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+/// Min-heap ordering for std::push_heap / std::pop_heap
+template <class Entry> bool lowerFirst(const Entry &a, const Entry &b)
+{
+    return a.f > b.f;
+}
+
+std::size_t gridSize(int width, int height)
+{
+    if (width <= 0 || height <= 0) throw std::runtime_error("Path grid: empty");
+
+    // One more id is used past the last cell, by HierarchicalPathfinder
+    const auto n = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    if (n >= static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+        throw std::runtime_error("Path grid: too many cells");
+    }
+    return n;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+PathGrid::PathGrid(int width_, int height_)
+    : width(width_), height(height_), cells(gridSize(width_, height_), 0)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+Pathfinder::Pathfinder(SharedPathGrid grid_) : grid(std::move(grid_))
+{
+}
+
+void Pathfinder::begin(const SDL_Rect *bounds)
+{
+    const auto n = grid->size();
+    if (g.size() != n) {
+        g.assign(n, Infinity);
+        parent.assign(n, -1);
+        seen.assign(n, 0);
+        closed.assign(n, 0);
+        generation = 0;
+    }
+    if (++generation == 0) {
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(closed.begin(), closed.end(), 0);
+        generation = 1;
+    }
+
+    open.clear();
+    limited = bounds != nullptr;
+    if (bounds) limitRect = *bounds;
+}
+
+void Pathfinder::push(int cell, float cost, int from, float h)
+{
+    const auto i = static_cast<std::size_t>(cell);
+    if (closed[i] == generation) return;
+    if (seen[i] == generation && cost >= g[i]) return;
+
+    seen[i] = generation;
+    g[i] = cost;
+    parent[i] = from;
+    open.push_back({cost + h, cell});
+    std::push_heap(open.begin(), open.end(), lowerFirst<OpenEntry>);
+}
+
+int Pathfinder::pop()
+{
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), lowerFirst<OpenEntry>);
+        const auto cell = open.back().cell;
+        open.pop_back();
+
+        // Cells are pushed again when a shorter path is found; skip the stale entries
+        auto &state = closed[static_cast<std::size_t>(cell)];
+        if (state == generation) continue;
+        state = generation;
+        return cell;
+    }
+    return -1;
+}
+
+bool Pathfinder::walkable(int x, int y) const noexcept
+{
+    if (limited && (x < limitRect.x || y < limitRect.y || x >= limitRect.x + limitRect.w ||
+                    y >= limitRect.y + limitRect.h)) {
+        return false;
+    }
+    return grid->isWalkable(x, y);
+}
+
+float Pathfinder::heuristic(int x, int y) const noexcept
+{
+    return octile(target.x - x, target.y - y);
+}
+
+bool Pathfinder::findPath(const mist::Point2i &start, const mist::Point2i &goal, Path &out,
+                          Algorithm algorithm, const SDL_Rect *bounds)
+{
+    out.clear();
+    begin(bounds);
+    if (!walkable(start.x, start.y) || !walkable(goal.x, goal.y)) return false;
+
+    const auto w = grid->getWidth();
+    const auto startCell = start.y * w + start.x;
+    const auto goalCell = goal.y * w + goal.x;
+    target = goal;
+
+    push(startCell, 0, -1, heuristic(start.x, start.y));
+    for (int cell = pop(); cell >= 0; cell = pop()) {
+        if (cell == goalCell) {
+            buildPath(goalCell, startCell, out);
+            return true;
+        }
+
+        if (algorithm == Algorithm::AStar)
+            expandAStar(cell, true);
+        else
+            expandJumpPoint(cell);
+    }
+    return false;
+}
+
+void Pathfinder::explore(const mist::Point2i &start, const SDL_Rect &bounds)
+{
+    begin(&bounds);
+    if (!walkable(start.x, start.y)) return;
+
+    target = start;
+    push(start.y * grid->getWidth() + start.x, 0, -1, 0);
+    for (int cell = pop(); cell >= 0; cell = pop())
+        expandAStar(cell, false);
+}
+
+float Pathfinder::getCost(const mist::Point2i &p) const noexcept
+{
+    if (!grid->contains(p.x, p.y) || g.empty()) return Infinity;
+
+    const auto i = grid->index(p.x, p.y);
+    return closed[i] == generation ? g[i] : Infinity;
+}
+
+void Pathfinder::expandAStar(int cell, bool useHeuristic)
+{
+    const auto w = grid->getWidth();
+    const auto x = cell % w;
+    const auto y = cell / w;
+    const auto cost = g[static_cast<std::size_t>(cell)];
+
+    for (const auto &[dx, dy] : Directions) {
+        const auto nx = x + dx;
+        const auto ny = y + dy;
+        if (!walkable(nx, ny)) continue;
+
+        const bool diagonal = dx != 0 && dy != 0;
+        if (diagonal && (!walkable(x + dx, y) || !walkable(x, y + dy))) continue;
+
+        push(ny * w + nx, cost + (diagonal ? Diagonal : 1.0f), cell,
+             useHeuristic ? heuristic(nx, ny) : 0.0f);
+    }
+}
+
+void Pathfinder::expandJumpPoint(int cell)
+{
+    const auto w = grid->getWidth();
+    const auto x = cell % w;
+    const auto y = cell / w;
+    const auto cost = g[static_cast<std::size_t>(cell)];
+
+    // Natural and forced neighbor directions, for movement without corner cutting
+    int  dirs[8][2];
+    int  count = 0;
+    auto add = [&](int dx, int dy) {
+        dirs[count][0] = dx;
+        dirs[count][1] = dy;
+        count++;
+    };
+
+    const auto from = parent[static_cast<std::size_t>(cell)];
+    if (from < 0) {
+        for (const auto &[dx, dy] : Directions) {
+            if (!walkable(x + dx, y + dy)) continue;
+            if (dx != 0 && dy != 0 && (!walkable(x + dx, y) || !walkable(x, y + dy))) continue;
+            add(dx, dy);
+        }
+    } else {
+        const auto dx = sign(x - from % w);
+        const auto dy = sign(y - from / w);
+
+        if (dx != 0 && dy != 0) {
+            const auto vertical = walkable(x, y + dy);
+            const auto horizontal = walkable(x + dx, y);
+            if (vertical) add(0, dy);
+            if (horizontal) add(dx, 0);
+            if (vertical && horizontal) add(dx, dy);
+        } else if (dx != 0) {
+            const auto next = walkable(x + dx, y);
+            const auto below = walkable(x, y + 1);
+            const auto above = walkable(x, y - 1);
+            if (next) {
+                add(dx, 0);
+                if (below) add(dx, 1);
+                if (above) add(dx, -1);
+            }
+            if (below) add(0, 1);
+            if (above) add(0, -1);
+        } else {
+            const auto next = walkable(x, y + dy);
+            const auto right = walkable(x + 1, y);
+            const auto left = walkable(x - 1, y);
+            if (next) {
+                add(0, dy);
+                if (right) add(1, dy);
+                if (left) add(-1, dy);
+            }
+            if (right) add(1, 0);
+            if (left) add(-1, 0);
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        const auto jumpPoint = jump(x + dirs[i][0], y + dirs[i][1], dirs[i][0], dirs[i][1]);
+        if (jumpPoint < 0) continue;
+
+        const auto jx = jumpPoint % w;
+        const auto jy = jumpPoint / w;
+        push(jumpPoint, cost + octile(jx - x, jy - y), cell, heuristic(jx, jy));
+    }
+}
+
+int Pathfinder::jump(int x, int y, int dx, int dy) const
+{
+    const auto w = grid->getWidth();
+
+    for (;;) {
+        if (!walkable(x, y)) return -1;
+        if (x == target.x && y == target.y) return y * w + x;
+
+        if (dx != 0 && dy != 0) {
+            // A diagonal move stops where a straight jump finds something
+            if (jump(x + dx, y, dx, 0) >= 0 || jump(x, y + dy, 0, dy) >= 0) return y * w + x;
+        } else if (dx != 0) {
+            if ((walkable(x, y - 1) && !walkable(x - dx, y - 1)) ||
+                (walkable(x, y + 1) && !walkable(x - dx, y + 1))) {
+                return y * w + x;
+            }
+        } else {
+            if ((walkable(x - 1, y) && !walkable(x - 1, y - dy)) ||
+                (walkable(x + 1, y) && !walkable(x + 1, y - dy))) {
+                return y * w + x;
+            }
+        }
+
+        if (!walkable(x + dx, y) || !walkable(x, y + dy)) return -1;
+        x += dx;
+        y += dy;
+    }
+}
+
+void Pathfinder::buildPath(int goalCell, int startCell, Path &out) const
+{
+    const auto w = grid->getWidth();
+    auto       x = goalCell % w;
+    auto       y = goalCell / w;
+    out.push_back({x, y});
+
+    // Jump points are on straight or diagonal lines, fill in the cells between them
+    for (int cell = goalCell; cell != startCell;) {
+        cell = parent[static_cast<std::size_t>(cell)];
+        const auto px = cell % w;
+        const auto py = cell / w;
+        while (x != px || y != py) {
+            x += sign(px - x);
+            y += sign(py - y);
+            out.push_back({x, y});
+        }
+    }
+    std::reverse(out.begin(), out.end());
+}
+
+/* -------------------------------------------------------------------------- */
+
+FlowField::FlowField(SharedPathGrid grid_) : grid(std::move(grid_))
+{
+}
+
+void FlowField::compute(const mist::Point2i &goal_)
+{
+    const auto w = grid->getWidth();
+    cost.assign(grid->size(), Infinity);
+    next.assign(grid->size(), -1);
+    open.clear();
+
+    goal = goal_;
+    if (!grid->isWalkable(goal.x, goal.y)) return;
+
+    auto byCost = [](const OpenEntry &a, const OpenEntry &b) { return a.cost > b.cost; };
+    auto relax = [&](int cell, float c, int towards) {
+        const auto i = static_cast<std::size_t>(cell);
+        if (c >= cost[i]) return;
+        cost[i] = c;
+        next[i] = towards;
+        open.push_back({c, cell});
+        std::push_heap(open.begin(), open.end(), byCost);
+    };
+
+    relax(goal.y * w + goal.x, 0, goal.y * w + goal.x);
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), byCost);
+        const auto entry = open.back();
+        open.pop_back();
+        if (entry.cost > cost[static_cast<std::size_t>(entry.cell)]) continue;
+
+        const auto x = entry.cell % w;
+        const auto y = entry.cell / w;
+        for (const auto &[dx, dy] : Directions) {
+            if (!grid->isWalkable(x + dx, y + dy)) continue;
+
+            const bool diagonal = dx != 0 && dy != 0;
+            if (diagonal && (!grid->isWalkable(x + dx, y) || !grid->isWalkable(x, y + dy)))
+                continue;
+
+            relax((y + dy) * w + x + dx, entry.cost + (diagonal ? Diagonal : 1.0f), entry.cell);
+        }
+    }
+}
+
+bool FlowField::isReachable(const mist::Point2i &p) const noexcept
+{
+    return getCost(p) != Infinity;
+}
+
+float FlowField::getCost(const mist::Point2i &p) const noexcept
+{
+    if (!grid->contains(p.x, p.y) || cost.empty()) return Infinity;
+    return cost[grid->index(p.x, p.y)];
+}
+
+mist::Point2i FlowField::getNext(const mist::Point2i &p) const noexcept
+{
+    if (!grid->contains(p.x, p.y) || next.empty()) return p;
+
+    const auto w = grid->getWidth();
+    const auto cell = next[grid->index(p.x, p.y)];
+    if (cell < 0) return p;
+    return {cell % w, cell / w};
+}
+
+/* -------------------------------------------------------------------------- */
+
+HierarchicalPathfinder::HierarchicalPathfinder(SharedPathGrid grid_, int clusterSize_)
+    : grid(std::move(grid_)), clusterSize(clusterSize_), local(grid)
+{
+    if (clusterSize < 2) throw std::runtime_error("Hierarchical pathfinder: cluster too small");
+    rebuild();
+}
+
+void HierarchicalPathfinder::rebuild()
+{
+    clustersX = (grid->getWidth() + clusterSize - 1) / clusterSize;
+    clustersY = (grid->getHeight() + clusterSize - 1) / clusterSize;
+    clusters.assign(static_cast<std::size_t>(clustersX) * static_cast<std::size_t>(clustersY), {});
+
+    for (int cy = 0; cy < clustersY; cy++) {
+        for (int cx = 0; cx < clustersX; cx++) {
+            const auto x = cx * clusterSize;
+            const auto y = cy * clusterSize;
+            clusters[static_cast<std::size_t>(cy * clustersX + cx)].bounds = {
+                x, y, std::min(clusterSize, grid->getWidth() - x),
+                std::min(clusterSize, grid->getHeight() - y)};
+        }
+    }
+
+    for (int i = 0; i < clustersX * clustersY; i++)
+        buildCluster(i);
+}
+
+void HierarchicalPathfinder::update(const SDL_Rect &changedTiles)
+{
+    // Entrances on the borders of changed clusters are shared with their neighbors
+    const auto cx0 = std::max(0, changedTiles.x / clusterSize - 1);
+    const auto cy0 = std::max(0, changedTiles.y / clusterSize - 1);
+    const auto cx1 =
+        std::min(clustersX - 1, (changedTiles.x + changedTiles.w - 1) / clusterSize + 1);
+    const auto cy1 =
+        std::min(clustersY - 1, (changedTiles.y + changedTiles.h - 1) / clusterSize + 1);
+
+    for (int cy = cy0; cy <= cy1; cy++)
+        for (int cx = cx0; cx <= cx1; cx++)
+            buildCluster(cy * clustersX + cx);
+}
+
+int HierarchicalPathfinder::getNumNodes() const noexcept
+{
+    int count = 0;
+    for (const auto &c : clusters)
+        count += static_cast<int>(c.nodes.size());
+    return count;
+}
+
+int HierarchicalPathfinder::clusterOf(int cell) const noexcept
+{
+    const auto w = grid->getWidth();
+    return (cell / w / clusterSize) * clustersX + (cell % w) / clusterSize;
+}
+
+/// Position of a cell along the border of its cluster: top, bottom, left, right; -1 if inside
+int HierarchicalPathfinder::borderSlot(const Cluster &cluster, int cell) const noexcept
+{
+    const auto  w = grid->getWidth();
+    const auto &b = cluster.bounds;
+    const auto  x = cell % w - b.x;
+    const auto  y = cell / w - b.y;
+
+    if (y == 0) return x;
+    if (y == b.h - 1) return b.w + x;
+    if (x == 0) return 2 * b.w + y;
+    if (x == b.w - 1) return 2 * b.w + b.h + y;
+    return -1;
+}
+
+int HierarchicalPathfinder::nodeIndex(const Cluster &cluster, int cell) const noexcept
+{
+    const auto slot = borderSlot(cluster, cell);
+    return slot < 0 ? -1 : cluster.borderNodes[static_cast<std::size_t>(slot)];
+}
+
+void HierarchicalPathfinder::buildCluster(int index)
+{
+    auto       &cluster = clusters[static_cast<std::size_t>(index)];
+    const auto &b = cluster.bounds;
+    const auto  cx = index % clustersX;
+    const auto  cy = index / clustersX;
+
+    cluster.nodes.clear();
+    cluster.borderNodes.assign(static_cast<std::size_t>(2 * (b.w + b.h)), -1);
+    if (cx > 0) addBorder(cluster, true, b.x, b.y, b.y + b.h - 1, -1);
+    if (cx < clustersX - 1) addBorder(cluster, true, b.x + b.w - 1, b.y, b.y + b.h - 1, 1);
+    if (cy > 0) addBorder(cluster, false, b.y, b.x, b.x + b.w - 1, -1);
+    if (cy < clustersY - 1) addBorder(cluster, false, b.y + b.h - 1, b.x, b.x + b.w - 1, 1);
+
+    const auto w = grid->getWidth();
+    const auto n = cluster.nodes.size();
+    cluster.distances.assign(n * n, Infinity);
+    for (std::size_t i = 0; i < n; i++) {
+        const auto from = cluster.nodes[i].cell;
+        local.explore({from % w, from / w}, b);
+        for (std::size_t j = 0; j < n; j++) {
+            const auto to = cluster.nodes[j].cell;
+            cluster.distances[i * n + j] = local.getCost({to % w, to / w});
+        }
+    }
+}
+
+void HierarchicalPathfinder::addBorder(Cluster &cluster, bool vertical, int fixed, int from,
+                                       int to, int step)
+{
+    const auto w = grid->getWidth();
+    auto       cellAt = [&](int along, int offset) {
+        return vertical ? (along * w + fixed + offset) : ((fixed + offset) * w + along);
+    };
+    auto passable = [&](int along) {
+        const auto a = cellAt(along, 0);
+        const auto b = cellAt(along, step);
+        return grid->isWalkable(a % w, a / w) && grid->isWalkable(b % w, b / w);
+    };
+    auto addTransition = [&](int along) {
+        const auto cell = cellAt(along, 0);
+        auto       index = nodeIndex(cluster, cell);
+        if (index < 0) {
+            index = static_cast<int>(cluster.nodes.size());
+            cluster.nodes.push_back({cell, {}});
+            cluster.borderNodes[static_cast<std::size_t>(borderSlot(cluster, cell))] = index;
+        }
+        cluster.nodes[static_cast<std::size_t>(index)].partners.push_back(cellAt(along, step));
+    };
+
+    // One transition in the middle of each open border segment, two for long segments.
+    // Both clusters sharing a border find the same segments, so transitions are symmetric.
+    for (int along = from; along <= to; along++) {
+        if (!passable(along)) continue;
+
+        const auto segmentStart = along;
+        while (along < to && passable(along + 1))
+            along++;
+
+        if (along - segmentStart + 1 >= 6) {
+            addTransition(segmentStart);
+            addTransition(along);
+        } else {
+            addTransition((segmentStart + along) / 2);
+        }
+    }
+}
+
+void HierarchicalPathfinder::push(int cell, float cost, int from, float h)
+{
+    const auto i = static_cast<std::size_t>(cell);
+    if (closed[i] == generation) return;
+    if (seen[i] == generation && cost >= g[i]) return;
+
+    seen[i] = generation;
+    g[i] = cost;
+    parent[i] = from;
+    open.push_back({cost + h, cell});
+    std::push_heap(open.begin(), open.end(), lowerFirst<OpenEntry>);
+}
+
+int HierarchicalPathfinder::pop()
+{
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), lowerFirst<OpenEntry>);
+        const auto cell = open.back().cell;
+        open.pop_back();
+
+        auto &state = closed[static_cast<std::size_t>(cell)];
+        if (state == generation) continue;
+        state = generation;
+        return cell;
+    }
+    return -1;
+}
+
+bool HierarchicalPathfinder::findPath(const mist::Point2i &start, const mist::Point2i &goal,
+                                      Path &out)
+{
+    using Algorithm = Pathfinder::Algorithm;
+
+    out.clear();
+    if (!grid->isWalkable(start.x, start.y) || !grid->isWalkable(goal.x, goal.y)) return false;
+
+    const auto w = grid->getWidth();
+    const auto startCell = start.y * w + start.x;
+    const auto goalCell = goal.y * w + goal.x;
+    const auto startCluster = clusterOf(startCell);
+    const auto goalCluster = clusterOf(goalCell);
+
+    if (startCluster == goalCluster &&
+        local.findPath(start, goal, out, Algorithm::AStar,
+                       &clusters[static_cast<std::size_t>(goalCluster)].bounds)) {
+        return true;
+    }
+
+    // Connect the goal to the entrances of its cluster
+    const auto &goalNodes = clusters[static_cast<std::size_t>(goalCluster)];
+    local.explore(goal, goalNodes.bounds);
+    goalDistances.resize(goalNodes.nodes.size());
+    for (std::size_t i = 0; i < goalNodes.nodes.size(); i++) {
+        const auto cell = goalNodes.nodes[i].cell;
+        goalDistances[i] = local.getCost({cell % w, cell / w});
+    }
+
+    // Abstract search over entrance cells; the extra slot past the last cell is the goal
+    const auto goalSlot = static_cast<int>(grid->size());
+    const auto n = grid->size() + 1;
+    if (g.size() != n) {
+        g.assign(n, Infinity);
+        parent.assign(n, -1);
+        seen.assign(n, 0);
+        closed.assign(n, 0);
+        generation = 0;
+    }
+    if (++generation == 0) {
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(closed.begin(), closed.end(), 0);
+        generation = 1;
+    }
+    open.clear();
+
+    auto h = [&](int cell) { return octile(goal.x - cell % w, goal.y - cell / w); };
+
+    // Connect the start to the entrances of its cluster
+    const auto &startNodes = clusters[static_cast<std::size_t>(startCluster)];
+    local.explore(start, startNodes.bounds);
+    for (const auto &node : startNodes.nodes) {
+        const auto cost = local.getCost({node.cell % w, node.cell / w});
+        if (cost != Infinity) push(node.cell, cost, -1, h(node.cell));
+    }
+
+    for (int cell = pop(); cell >= 0; cell = pop()) {
+        if (cell == goalSlot) break;
+
+        const auto  clusterIndex = clusterOf(cell);
+        const auto &cluster = clusters[static_cast<std::size_t>(clusterIndex)];
+        const auto  k = nodeIndex(cluster, cell);
+        if (k < 0) continue;
+
+        const auto cost = g[static_cast<std::size_t>(cell)];
+        const auto numNodes = cluster.nodes.size();
+        const auto row = static_cast<std::size_t>(k) * numNodes;
+
+        if (clusterIndex == goalCluster) {
+            const auto toGoal = goalDistances[static_cast<std::size_t>(k)];
+            if (toGoal != Infinity) push(goalSlot, cost + toGoal, cell, 0);
+        }
+        for (std::size_t j = 0; j < numNodes; j++) {
+            const auto d = cluster.distances[row + j];
+            const auto other = cluster.nodes[j].cell;
+            if (d != Infinity && d > 0) push(other, cost + d, cell, h(other));
+        }
+        for (const auto partner : cluster.nodes[static_cast<std::size_t>(k)].partners)
+            push(partner, cost + 1.0f, cell, h(partner));
+    }
+
+    if (closed[static_cast<std::size_t>(goalSlot)] != generation) return false;
+
+    // Abstract path: start, entrances..., goal
+    waypoints.clear();
+    waypoints.push_back(goalCell);
+    for (int cell = parent[static_cast<std::size_t>(goalSlot)]; cell >= 0;
+         cell = parent[static_cast<std::size_t>(cell)]) {
+        waypoints.push_back(cell);
+    }
+    waypoints.push_back(startCell);
+    std::reverse(waypoints.begin(), waypoints.end());
+
+    out.push_back(start);
+    for (std::size_t i = 1; i < waypoints.size(); i++)
+        appendSegment(waypoints[i - 1], waypoints[i], out);
+    return true;
+}
+
+void HierarchicalPathfinder::appendSegment(int from, int to, Path &out)
+{
+    if (from == to) return;
+
+    const auto w = grid->getWidth();
+    const auto fromCluster = clusterOf(from);
+    if (fromCluster != clusterOf(to)) {
+        // Step across a cluster border
+        out.push_back({to % w, to / w});
+        return;
+    }
+
+    local.findPath({from % w, from / w}, {to % w, to / w}, segment,
+                   Pathfinder::Algorithm::AStar,
+                   &clusters[static_cast<std::size_t>(fromCluster)].bounds);
+    out.insert(out.end(), segment.begin() + 1, segment.end());
+}
@@ -0,0 +1,254 @@
+#ifndef SKY_PATHFINDING_H_
+#define SKY_PATHFINDING_H_
+
+#include "Tiles.h"
+
+#include <mist/Point.h>
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sky
+{
+
+using Path = std::vector<mist::Point2i>;
+
+/**
+ * @brief Walkability of every cell of a tile grid, one byte per cell
+ *
+ * Built from a TileMap with a walkability predicate. After editing the map, refresh the
+ * changed area with update() and pass the same area to HierarchicalPathfinder::update().
+ *
+ * The searches identify cells by an int, y * width + x, so a grid holds fewer than INT_MAX
+ * cells; larger grids are rejected.
+ */
+class PathGrid
+{
+public:
+    PathGrid(int width, int height);
+
+    template <class Cell, class Predicate>
+    static PathGrid fromTileMap(const BasicTileMap<Cell> &map, Predicate isWalkable,
+                                int layer = 0)
+    {
+        PathGrid grid(map.getWidth(), map.getHeight());
+        grid.update(map, isWalkable, SDL_Rect {0, 0, map.getWidth(), map.getHeight()}, layer);
+        return grid;
+    }
+
+    template <class Cell, class Predicate>
+    void update(const BasicTileMap<Cell> &map, Predicate isWalkable, const SDL_Rect &area,
+                int layer = 0)
+    {
+        for (int y = area.y; y < area.y + area.h; y++)
+            for (int x = area.x; x < area.x + area.w; x++)
+                setWalkable({x, y}, isWalkable(map.at(layer, {x, y})));
+    }
+
+    [[nodiscard]] int getWidth() const noexcept { return width; }
+    [[nodiscard]] int getHeight() const noexcept { return height; }
+
+    [[nodiscard]] bool contains(int x, int y) const noexcept
+    {
+        return x >= 0 && y >= 0 && x < width && y < height;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return cells.size(); }
+
+    /// @brief Index of a cell, for per-cell buffers of size()
+    [[nodiscard]] std::size_t index(int x, int y) const noexcept
+    {
+        return static_cast<std::size_t>(y) * static_cast<std::size_t>(width) +
+               static_cast<std::size_t>(x);
+    }
+
+    [[nodiscard]] bool isWalkable(int x, int y) const noexcept
+    {
+        return contains(x, y) && cells[index(x, y)] != 0;
+    }
+
+    void setWalkable(const mist::Point2i &p, bool walkable)
+    {
+        cells[index(p.x, p.y)] = walkable ? 1 : 0;
+    }
+
+private:
+    int                       width;
+    int                       height;
+    std::vector<std::uint8_t> cells;
+};
+
+using SharedPathGrid = std::shared_ptr<const PathGrid>;
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief A* and Jump Point Search on a PathGrid
+ *
+ * Moves go to all 8 neighbors; diagonal moves are only allowed when both adjacent orthogonal
+ * cells are walkable (no corner cutting). Both algorithms return the same, optimal path
+ * length, as a list of every cell from start to goal.
+ *
+ * Search buffers are kept between calls and reset with a generation counter, so repeated
+ * searches do not allocate once the buffers have grown. Pass the same Path to reuse it too.
+ */
+class Pathfinder
+{
+public:
+    enum class Algorithm { AStar, JumpPoint };
+
+    explicit Pathfinder(SharedPathGrid grid);
+
+    /**
+     * @arg bounds if given, the search does not leave this rect
+     * @return false if there is no path
+     */
+    bool findPath(const mist::Point2i &start, const mist::Point2i &goal, Path &out,
+                  Algorithm algorithm = Algorithm::JumpPoint, const SDL_Rect *bounds = nullptr);
+
+    /// @brief Compute costs from start to all cells within bounds, read them with getCost()
+    void explore(const mist::Point2i &start, const SDL_Rect &bounds);
+
+    /// @brief Cost of the cell from the last explore(); infinity if not reached
+    [[nodiscard]] float getCost(const mist::Point2i &p) const noexcept;
+
+private:
+    struct OpenEntry {
+        float f;
+        int   cell;
+    };
+
+    SharedPathGrid grid;
+
+    std::vector<float>         g;
+    std::vector<int>           parent;
+    std::vector<std::uint32_t> seen;
+    std::vector<std::uint32_t> closed;
+    std::vector<OpenEntry>     open;
+    std::uint32_t              generation {0};
+
+    SDL_Rect      limitRect {0, 0, 0, 0};
+    bool          limited {false};
+    mist::Point2i target {0, 0};
+
+    void  begin(const SDL_Rect *bounds);
+    void  push(int cell, float cost, int from, float h);
+    int   pop();
+    bool  walkable(int x, int y) const noexcept;
+    float heuristic(int x, int y) const noexcept;
+    void  expandAStar(int cell, bool useHeuristic);
+    void  expandJumpPoint(int cell);
+    int   jump(int x, int y, int dx, int dy) const;
+    void  buildPath(int goalCell, int startCell, Path &out) const;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Paths to a single goal for any number of agents
+ *
+ * compute() runs one Dijkstra search from the goal over the whole grid. Afterwards every
+ * agent finds its next step with getNext() in constant time.
+ */
+class FlowField
+{
+public:
+    explicit FlowField(SharedPathGrid grid);
+
+    void compute(const mist::Point2i &goal);
+
+    [[nodiscard]] const mist::Point2i &getGoal() const noexcept { return goal; }
+    [[nodiscard]] bool                 isReachable(const mist::Point2i &p) const noexcept;
+    [[nodiscard]] float                getCost(const mist::Point2i &p) const noexcept;
+    /// @brief Next cell on the way to the goal; p itself at the goal or if unreachable
+    [[nodiscard]] mist::Point2i getNext(const mist::Point2i &p) const noexcept;
+
+private:
+    struct OpenEntry {
+        float cost;
+        int   cell;
+    };
+
+    SharedPathGrid         grid;
+    mist::Point2i          goal {0, 0};
+    std::vector<float>     cost;
+    std::vector<int>       next;
+    std::vector<OpenEntry> open;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief HPA* - hierarchical path planning for large grids
+ *
+ * The grid is split into square clusters. Entrances on the borders between clusters become
+ * nodes of an abstract graph, connected by precomputed in-cluster distances. A query searches
+ * the small abstract graph and refines it into cells with searches bounded to one cluster.
+ * Paths are near-optimal.
+ *
+ * After changing the grid, update() rebuilds only the clusters touching the changed area and
+ * their neighbors.
+ */
+class HierarchicalPathfinder
+{
+public:
+    explicit HierarchicalPathfinder(SharedPathGrid grid, int clusterSize = 16);
+
+    void rebuild();
+    void update(const SDL_Rect &changedTiles);
+
+    bool findPath(const mist::Point2i &start, const mist::Point2i &goal, Path &out);
+
+    [[nodiscard]] int getNumNodes() const noexcept;
+
+private:
+    struct Node {
+        int              cell;
+        std::vector<int> partners; ///< entrance cells on the other side of a border
+    };
+
+    struct Cluster {
+        SDL_Rect           bounds;
+        std::vector<Node>  nodes;
+        std::vector<float> distances;   ///< nodes.size() squared, infinity if not connected
+        std::vector<int>   borderNodes; ///< node index of every border cell, -1 if none
+    };
+
+    struct OpenEntry {
+        float f;
+        int   cell;
+    };
+
+    SharedPathGrid       grid;
+    const int            clusterSize;
+    int                  clustersX {0};
+    int                  clustersY {0};
+    std::vector<Cluster> clusters;
+    Pathfinder           local;
+
+    std::vector<float>         g;
+    std::vector<int>           parent;
+    std::vector<std::uint32_t> seen;
+    std::vector<std::uint32_t> closed;
+    std::vector<OpenEntry>     open;
+    std::vector<float>         goalDistances;
+    std::vector<int>           waypoints;
+    Path                       segment;
+    std::uint32_t              generation {0};
+
+    [[nodiscard]] int clusterOf(int cell) const noexcept;
+    [[nodiscard]] int borderSlot(const Cluster &cluster, int cell) const noexcept;
+    [[nodiscard]] int nodeIndex(const Cluster &cluster, int cell) const noexcept;
+
+    void buildCluster(int index);
+    void addBorder(Cluster &cluster, bool vertical, int fixed, int from, int to, int step);
+    void push(int cell, float cost, int from, float h);
+    int  pop();
+    void appendSegment(int from, int to, Path &out);
+};
+
+} // namespace sky
+
+#endif
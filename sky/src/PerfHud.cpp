@@ -0,0 +1,100 @@
+#include "PerfHud.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string_view>
+
+using namespace sky;
+
+namespace
+{
+
+constexpr Color TextColor {255, 255, 255, 255};
+constexpr float BudgetMs = 1000.0f / 60.0f;
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+PerfHud::PerfHud(std::shared_ptr<Font> font_)
+    : font(std::move(font_)), lineHeight(font->measure("Ag").y)
+{
+}
+
+int PerfHud::getHeight() const noexcept
+{
+    return 3 * Padding + NumLines * lineHeight + GraphHeight;
+}
+
+void PerfHud::record(const FrameStats &stats) noexcept
+{
+    if (stats.frame == lastFrame) return;
+    lastFrame = stats.frame;
+
+    history[static_cast<std::size_t>(head)] = static_cast<float>(stats.frameMs);
+    head = (head + 1) % HistoryLength;
+
+    frames++;
+    frameMs += stats.frameMs;
+    drawMs += stats.drawMs;
+    updateMs += stats.updateMs;
+    if (stats.allocations > 0) allocations += stats.allocations;
+
+    if (frameMs < RefreshMs) return;
+    refresh(stats);
+    frames = 0;
+    frameMs = drawMs = updateMs = 0;
+    allocations = 0;
+}
+
+void PerfHud::refresh(const FrameStats &last) noexcept
+{
+    const auto n = static_cast<double>(frames);
+    const auto averageMs = frameMs / n;
+
+    std::snprintf(lines[0].data(), LineLength, "%.1f FPS  %.2f ms", 1000.0 / averageMs,
+                  averageMs);
+    std::snprintf(lines[1].data(), LineLength, "update %.2f ms  draw %.2f ms", updateMs / n,
+                  drawMs / n);
+    std::snprintf(lines[2].data(), LineLength, "draw calls %d  textures %d", last.drawCalls,
+                  last.textures);
+    if (last.allocations < 0)
+        std::snprintf(lines[3].data(), LineLength, "allocations n/a");
+    else
+        std::snprintf(lines[3].data(), LineLength, "allocations %.1f / frame",
+                      static_cast<double>(allocations) / n);
+}
+
+void PerfHud::draw(Renderer &renderer, int x, int y, double)
+{
+    SDL_Rect      background {x, y, Width, getHeight()};
+    SDL_BlendMode previousBlendMode;
+    SDL_GetRenderDrawBlendMode(renderer, &previousBlendMode);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+    SDL_RenderFillRect(renderer, &background);
+    renderer.countDrawCalls();
+
+    auto top = y + Padding;
+    for (const auto &line : lines) {
+        font->drawText(renderer, std::string_view(line.data()), x + Padding, top, TextColor);
+        top += lineHeight;
+    }
+
+    // Oldest frame on the left, over a line at the 60 FPS budget
+    const auto bottom = top + Padding + GraphHeight;
+    auto       toY = [&](float ms) {
+        return bottom - static_cast<int>(std::min(ms, GraphMaxMs) / GraphMaxMs * GraphHeight);
+    };
+    for (int i = 0; i < HistoryLength; i++) {
+        const auto ms = history[static_cast<std::size_t>((head + i) % HistoryLength)];
+        points[static_cast<std::size_t>(i)] = {x + Padding + 2 * i, toY(ms)};
+    }
+
+    SDL_SetRenderDrawColor(renderer, 96, 96, 96, 255);
+    SDL_RenderDrawLine(renderer, x + Padding, toY(BudgetMs), x + Width - Padding, toY(BudgetMs));
+    SDL_SetRenderDrawColor(renderer, 64, 255, 64, 255);
+    SDL_RenderDrawLines(renderer, points.data(), HistoryLength);
+    renderer.countDrawCalls(2);
+    SDL_SetRenderDrawBlendMode(renderer, previousBlendMode);
+}
@@ -0,0 +1,74 @@
+#ifndef SKY_PERFHUD_H_
+#define SKY_PERFHUD_H_
+
+#include "Color.h"
+#include "Sky.h"
+#include "SkyEngine.h"
+
+#include <SDL2/SDL.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace sky
+{
+
+/**
+ * @brief Overlay of FrameStats: FPS, frame-time graph, update/draw split, draw calls, live
+ * textures and heap allocations
+ *
+ * The cost of drawing is fixed and small: one background fill, one batch of lines for the
+ * graph, and one glyph atlas batch per line of text. Text is formatted into fixed buffers,
+ * averaged over and refreshed only a few times per second, so the overlay itself neither
+ * allocates nor renders text textures.
+ *
+ * Call record() once per frame, visible or not, to keep the graph history complete.
+ */
+class PerfHud : public Drawable
+{
+public:
+    explicit PerfHud(std::shared_ptr<Font> font);
+
+    void record(const FrameStats &stats) noexcept;
+
+    /// @arg x, y top left corner
+    void draw(Renderer &renderer, int x, int y, double angle) override;
+
+    [[nodiscard]] int getWidth() const noexcept { return Width; }
+    [[nodiscard]] int getHeight() const noexcept;
+
+private:
+    static constexpr int   HistoryLength = 120;
+    static constexpr int   Padding = 4;
+    static constexpr int   Width = HistoryLength * 2 + 2 * Padding;
+    static constexpr int   GraphHeight = 48;
+    static constexpr float GraphMaxMs = 50.0f;
+    static constexpr double RefreshMs = 250.0;
+    static constexpr int   NumLines = 4;
+    static constexpr int   LineLength = 64;
+
+    std::shared_ptr<Font> font;
+    int                   lineHeight;
+
+    std::array<float, HistoryLength>     history {}; ///< frame times, oldest at head
+    int                                  head {0};
+    std::uint64_t                        lastFrame {0};
+    std::array<SDL_Point, HistoryLength> points {};
+
+    // Sums over the current refresh period
+    int          frames {0};
+    double       frameMs {0};
+    double       drawMs {0};
+    double       updateMs {0};
+    std::int64_t allocations {0};
+
+    std::array<std::array<char, LineLength>, NumLines> lines {};
+
+    void refresh(const FrameStats &last) noexcept;
+};
+
+using SharedPerfHud = std::shared_ptr<PerfHud>;
+
+} // namespace sky
+
+#endif
@@ -0,0 +1,173 @@
+#include "Pixels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace sky;
+
+namespace
+{
+
+/// Packs 8-bit channels with the shifts of a 32bpp format, valid for all 32bpp formats. Held
+/// by value, so the pixel loops read the shifts from registers rather than through a pointer
+/// the row stores might alias.
+struct ChannelPacker {
+    Uint32 rShift;
+    Uint32 gShift;
+    Uint32 bShift;
+    Uint32 aShift;
+    Uint32 aMask;
+
+    explicit ChannelPacker(const SDL_PixelFormat *f) noexcept
+        : rShift(f->Rshift), gShift(f->Gshift), bShift(f->Bshift), aShift(f->Ashift),
+          aMask(f->Amask)
+    {
+    }
+
+    [[nodiscard]] Uint32 operator()(Uint32 r, Uint32 g, Uint32 b, Uint32 a) const noexcept
+    {
+        return (r << rShift) | (g << gShift) | (b << bShift) | ((a << aShift) & aMask);
+    }
+};
+
+/// Linear ramp of an 8-bit channel over steps steps, in 16.16 fixed point, so each step is an
+/// add instead of a division. Exact at both ends for up to 32768 steps.
+struct ChannelRamp {
+    Sint32 value;
+    Sint32 step;
+
+    ChannelRamp(Uint8 from, Uint8 to, int steps) noexcept
+        : value((Sint32 {from} << 16) + 0x8000), step((Sint32 {to} - from) * 0x10000 / steps)
+    {
+    }
+
+    Uint32 next() noexcept
+    {
+        const auto current = static_cast<Uint32>(value) >> 16u;
+        value += step;
+        return current;
+    }
+};
+
+void copyFirstRow(const PixelSpan &span)
+{
+    const auto rowBytes = static_cast<size_t>(span.width) * sizeof(Uint32);
+    for (int y = 1; y < span.height; y++)
+        std::memcpy(span.row(y), span.row(0), rowBytes);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+PixelSpan PixelSpan::of(SDL_Surface *surface, const SDL_Rect &rect)
+{
+    if (surface->format->BytesPerPixel != 4) {
+        throw std::runtime_error("Pixel span: surface is not 32 bits per pixel");
+    }
+
+    auto *base = static_cast<Uint8 *>(surface->pixels) + rect.y * surface->pitch +
+                 rect.x * static_cast<int>(sizeof(Uint32));
+    return {reinterpret_cast<Uint32 *>(base), surface->pitch / static_cast<int>(sizeof(Uint32)),
+            rect.w, rect.h, surface->format};
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PixelKernels::fill(const PixelSpan &span, const Color &color)
+{
+    if (span.width <= 0 || span.height <= 0) return;
+
+    std::fill_n(span.row(0), span.width, span.pack(color));
+    copyFirstRow(span);
+}
+
+void PixelKernels::horizontalGradient(const PixelSpan &span, const Color &from, const Color &to)
+{
+    if (span.width <= 0 || span.height <= 0) return;
+
+    const ChannelPacker pack(span.format);
+    const auto          steps = std::max(1, span.width - 1);
+    ChannelRamp         r(from.r, to.r, steps);
+    ChannelRamp         g(from.g, to.g, steps);
+    ChannelRamp         b(from.b, to.b, steps);
+    ChannelRamp         a(from.a, to.a, steps);
+
+    Uint32   *row = span.row(0);
+    const int width = span.width;
+    for (int x = 0; x < width; x++)
+        row[x] = pack(r.next(), g.next(), b.next(), a.next());
+    copyFirstRow(span);
+}
+
+void PixelKernels::verticalGradient(const PixelSpan &span, const Color &from, const Color &to)
+{
+    const ChannelPacker pack(span.format);
+    const auto          steps = std::max(1, span.height - 1);
+    ChannelRamp         r(from.r, to.r, steps);
+    ChannelRamp         g(from.g, to.g, steps);
+    ChannelRamp         b(from.b, to.b, steps);
+    ChannelRamp         a(from.a, to.a, steps);
+
+    for (int y = 0; y < span.height; y++)
+        std::fill_n(span.row(y), span.width, pack(r.next(), g.next(), b.next(), a.next()));
+}
+
+void PixelKernels::noise(const PixelSpan &span, const Color &color, Uint8 amount, Uint32 seed)
+{
+    const Uint32 r = color.r;
+    const Uint32 g = color.g;
+    const Uint32 b = color.b;
+    const Uint32 a = color.a;
+
+    const ChannelPacker pack(span.format);
+    const int           width = span.width;
+    for (int y = 0; y < span.height; y++) {
+        Uint32      *row = span.row(y);
+        const Uint32 rowSeed = seed ^ (static_cast<Uint32>(y) * 0x85ebca77u);
+
+        for (int x = 0; x < width; x++) {
+            // Integer hash of (x, y, seed), only multiplies, xors and shifts
+            Uint32 h = (static_cast<Uint32>(x) * 0x9e3779b1u) ^ rowSeed;
+            h ^= h >> 15u;
+            h *= 0x2c1b3c6du;
+            h ^= h >> 12u;
+
+            const Uint32 scale = 256u - (((h & 0xffu) * amount) >> 8u);
+            row[x] = pack((r * scale) >> 8u, (g * scale) >> 8u, (b * scale) >> 8u, a);
+        }
+    }
+}
+
+void PixelKernels::ditherGradient(const PixelSpan &span, const Color &from, const Color &to)
+{
+    static constexpr Uint8 bayer[4][4] = {
+        {0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5}};
+
+    if (span.width <= 0) return;
+
+    const auto colorFrom = span.pack(from);
+    const auto colorTo = span.pack(to);
+    const auto width = span.width;
+    const auto steps = std::max(1, width - 1);
+
+    // The pattern repeats every 4 rows, so only those are computed and then copied
+    const auto rowBytes = static_cast<size_t>(width) * sizeof(Uint32);
+    for (int y = 0; y < span.height; y++) {
+        Uint32 *row = span.row(y);
+        if (y >= 4) {
+            std::memcpy(row, span.row(y - 4), rowBytes);
+            continue;
+        }
+
+        // Level x * 16 / steps, 0 - all pixels from, 16 - all pixels to, is above threshold
+        // t exactly when x * 16 >= (t + 1) * steps, which needs no division
+        const int limits[4] = {(bayer[y][0] + 1) * steps, (bayer[y][1] + 1) * steps,
+                               (bayer[y][2] + 1) * steps, (bayer[y][3] + 1) * steps};
+        for (int x = 0; x < width; x++) {
+            const auto mask = 0u - static_cast<Uint32>(x * 16 >= limits[x & 3]);
+            row[x] = colorFrom ^ ((colorFrom ^ colorTo) & mask);
+        }
+    }
+}
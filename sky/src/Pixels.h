@@ -0,0 +1,68 @@
+#ifndef SKY_PIXELS_H_
+#define SKY_PIXELS_H_
+
+#include "Color.h"
+
+#include <SDL2/SDL.h>
+
+namespace sky
+{
+
+/**
+ * @brief A rectangle of 32-bit pixels inside a locked SDL_Surface
+ *
+ * pitch is in pixels, not bytes. Use pack() to convert colors to the surface pixel format.
+ */
+struct PixelSpan {
+    Uint32                *pixels;
+    int                    pitch;
+    int                    width;
+    int                    height;
+    const SDL_PixelFormat *format;
+
+    /// @brief Span covering rect of a locked 32bpp surface
+    static PixelSpan of(SDL_Surface *surface, const SDL_Rect &rect);
+
+    [[nodiscard]] Uint32 *row(int y) const noexcept { return pixels + y * pitch; }
+
+    [[nodiscard]] Uint32 pack(const Color &c) const noexcept
+    {
+        return SDL_MapRGBA(format, c.r, c.g, c.b, c.a);
+    }
+};
+
+/**
+ * @brief Pixel kernels for PixelSpans
+ *
+ * The inner loops work on contiguous rows of Uint32 with no calls, branches or divisions on
+ * the pixel path, and read the pixel format into locals first, so the compiler can vectorize
+ * them. Gradients step in fixed point. Where possible a single row is computed and copied to
+ * the remaining rows.
+ */
+namespace PixelKernels
+{
+
+void fill(const PixelSpan &span, const Color &color);
+
+/// @brief Linear gradient from left edge to right edge
+void horizontalGradient(const PixelSpan &span, const Color &from, const Color &to);
+
+/// @brief Linear gradient from top edge to bottom edge
+void verticalGradient(const PixelSpan &span, const Color &from, const Color &to);
+
+/**
+ * @brief Fill with color, with the brightness of each pixel randomly reduced
+ *
+ * @arg amount 0 - plain color, 255 - brightness anywhere from 0 to full
+ * @arg seed the same seed always produces the same pattern
+ */
+void noise(const PixelSpan &span, const Color &color, Uint8 amount, Uint32 seed);
+
+/// @brief Two-color horizontal gradient using an ordered (4x4 Bayer) dither pattern
+void ditherGradient(const PixelSpan &span, const Color &from, const Color &to);
+
+} // namespace PixelKernels
+
+} // namespace sky
+
+#endif
@@ -0,0 +1,109 @@
+#include "Sky.h"
+
+using namespace sky;
+
+namespace
+{
+
+/// Rough size of an open TTF font and its glyph atlas
+constexpr std::size_t FontBytes = 512 * 1024;
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+std::size_t sky::resourceBytes(const Texture &texture) noexcept
+{
+    return static_cast<std::size_t>(texture.getWidth()) *
+           static_cast<std::size_t>(texture.getHeight()) * 4;
+}
+
+std::size_t sky::resourceBytes(const Font &) noexcept
+{
+    return FontBytes;
+}
+
+/* -------------------------------------------------------------------------- */
+
+ResourceCache::ResourceCache(std::size_t budgetBytes) : budget(budgetBytes)
+{
+}
+
+ResourceCache &ResourceCache::shared()
+{
+    static ResourceCache instance;
+    return instance;
+}
+
+void ResourceCache::retain(const void *key, const std::shared_ptr<const void> &object,
+                           std::size_t bytes)
+{
+    if (auto it = index.find(key); it != index.end()) {
+        auto &entry = *it->second;
+        if (entry.object != object) entry.object = object;
+        if (entry.bytes != bytes) {
+            stats.bytes += bytes - entry.bytes;
+            if (entry.pinned) stats.pinnedBytes += bytes - entry.bytes;
+            entry.bytes = bytes;
+        }
+        if (entry.pinned) return;
+        lru.splice(lru.begin(), lru, it->second);
+    } else {
+        lru.push_front({key, object, bytes, false});
+        index.emplace(key, lru.begin());
+        stats.bytes += bytes;
+        stats.entries++;
+    }
+    evict();
+}
+
+void ResourceCache::pin(const void *key, bool enable)
+{
+    const auto it = index.find(key);
+    if (it == index.end() || it->second->pinned == enable) return;
+
+    auto &entry = *it->second;
+    entry.pinned = enable;
+    if (enable) {
+        stats.pinnedBytes += entry.bytes;
+        pinned.splice(pinned.begin(), lru, it->second);
+    } else {
+        stats.pinnedBytes -= entry.bytes;
+        lru.splice(lru.begin(), pinned, it->second);
+        evict();
+    }
+}
+
+void ResourceCache::release(const void *key)
+{
+    if (auto it = index.find(key); it != index.end()) erase(it->second);
+}
+
+void ResourceCache::setBudget(std::size_t bytes)
+{
+    budget = bytes;
+    evict();
+}
+
+void ResourceCache::clear()
+{
+    while (!lru.empty())
+        erase(std::prev(lru.end()));
+}
+
+void ResourceCache::evict()
+{
+    while (stats.bytes > budget && lru.size() > 1) {
+        erase(std::prev(lru.end()));
+        stats.evictions++;
+    }
+}
+
+void ResourceCache::erase(Entries::iterator entry)
+{
+    stats.bytes -= entry->bytes;
+    if (entry->pinned) stats.pinnedBytes -= entry->bytes;
+    stats.entries--;
+    index.erase(entry->key);
+    (entry->pinned ? pinned : lru).erase(entry);
+}
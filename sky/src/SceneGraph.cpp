@@ -0,0 +1,100 @@
+#include "SceneGraph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+using namespace sky;
+
+SceneGraph::NodeId SceneGraph::add(SharedObject object, NodeId parent)
+{
+    if (parent != None && (parent < 0 || parent >= size())) {
+        throw std::runtime_error("Scene graph: invalid parent node");
+    }
+
+    const auto node = size();
+    parents.push_back(parent);
+    localPositions.push_back(object->position);
+    localHeadings.push_back(object->heading);
+    worldPositions.push_back(object->position);
+    worldHeadings.push_back(object->heading);
+    dirty.push_back(1);
+    objects.emplace_back(std::move(object));
+    anyDirty = true;
+
+    return node;
+}
+
+void SceneGraph::clear()
+{
+    parents.clear();
+    localPositions.clear();
+    localHeadings.clear();
+    worldPositions.clear();
+    worldHeadings.clear();
+    dirty.clear();
+    objects.clear();
+    anyDirty = false;
+}
+
+void SceneGraph::setLocalPosition(NodeId node, mist::Point2d position)
+{
+    localPositions[index(node)] = position;
+    markDirty(node);
+}
+
+void SceneGraph::setLocalHeading(NodeId node, double heading)
+{
+    localHeadings[index(node)] = heading;
+    markDirty(node);
+}
+
+void SceneGraph::setLocal(NodeId node, mist::Point2d position, double heading)
+{
+    localPositions[index(node)] = position;
+    localHeadings[index(node)] = heading;
+    markDirty(node);
+}
+
+void SceneGraph::markDirty(NodeId node)
+{
+    dirty[index(node)] = 1;
+    anyDirty = true;
+}
+
+void SceneGraph::update()
+{
+    if (!anyDirty) return;
+
+    // Parents precede their children, so one forward pass propagates dirty flags down
+    // the tree and always sees an up to date parent transform
+    for (std::size_t i = 0; i < parents.size(); i++) {
+        const auto parent = parents[i];
+
+        if (parent == None) {
+            if (!dirty[i]) continue;
+            worldPositions[i] = localPositions[i];
+            worldHeadings[i] = localHeadings[i];
+        } else {
+            const auto p = index(parent);
+            if (!dirty[i] && !dirty[p]) continue;
+            dirty[i] = 1;
+
+            const auto  angle = worldHeadings[p] * std::numbers::pi / 180.0;
+            const auto  c = std::cos(angle);
+            const auto  s = std::sin(angle);
+            const auto &local = localPositions[i];
+
+            worldPositions[i] = {worldPositions[p].x + local.x * c - local.y * s,
+                                 worldPositions[p].y + local.x * s + local.y * c};
+            worldHeadings[i] = worldHeadings[p] + localHeadings[i];
+        }
+
+        objects[i]->position = worldPositions[i];
+        objects[i]->heading = worldHeadings[i];
+    }
+
+    std::fill(dirty.begin(), dirty.end(), 0);
+    anyDirty = false;
+}
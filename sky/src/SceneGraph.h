@@ -0,0 +1,83 @@
+#ifndef SKY_SCENEGRAPH_H_
+#define SKY_SCENEGRAPH_H_
+
+#include "SkyEngine.h"
+
+#include <mist/Point.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace sky
+{
+
+/**
+ * @brief Parent/child relationships between Objects
+ *
+ * Each node holds a transform local to its parent. update() computes world transforms and
+ * writes them to Object::position and Object::heading of the attached objects, so the
+ * objects can be drawn by EngineScene as usual.
+ *
+ * Nodes are stored in flat arrays. A parent always has to be added before its children, so
+ * the storage order is also a topological order and world transforms are computed in a single
+ * forward pass. Only nodes whose local transform changed, and their descendants, are
+ * recomputed.
+ *
+ * Child positions are rotated by the parent heading (degrees, as Object::heading). This
+ * matches the on-screen rotation of Drawables when the world Y axis points down, as with
+ * Transforms::tiles().
+ */
+class SceneGraph
+{
+public:
+    using NodeId = int;
+    static constexpr NodeId None = -1;
+
+    SceneGraph() = default;
+
+    /// @brief Attach object as a child of parent; its current position and heading become
+    /// the local transform
+    NodeId add(SharedObject object, NodeId parent = None);
+    void   clear();
+
+    [[nodiscard]] int    size() const noexcept { return static_cast<int>(parents.size()); }
+    [[nodiscard]] NodeId getParent(NodeId node) const { return parents[index(node)]; }
+
+    void setLocalPosition(NodeId node, mist::Point2d position);
+    void setLocalHeading(NodeId node, double heading);
+    void setLocal(NodeId node, mist::Point2d position, double heading);
+
+    [[nodiscard]] mist::Point2d getLocalPosition(NodeId node) const
+    {
+        return localPositions[index(node)];
+    }
+    [[nodiscard]] double getLocalHeading(NodeId node) const { return localHeadings[index(node)]; }
+
+    /// @brief World transforms are valid after update()
+    [[nodiscard]] mist::Point2d getWorldPosition(NodeId node) const
+    {
+        return worldPositions[index(node)];
+    }
+    [[nodiscard]] double getWorldHeading(NodeId node) const { return worldHeadings[index(node)]; }
+
+    void update();
+
+private:
+    std::vector<NodeId>        parents;
+    std::vector<mist::Point2d> localPositions;
+    std::vector<double>        localHeadings;
+    std::vector<mist::Point2d> worldPositions;
+    std::vector<double>        worldHeadings;
+    std::vector<std::uint8_t>  dirty;
+    std::vector<SharedObject>  objects;
+
+    bool anyDirty {false};
+
+    static std::size_t index(NodeId node) { return static_cast<std::size_t>(node); }
+
+    void markDirty(NodeId node);
+};
+
+} // namespace sky
+
+#endif
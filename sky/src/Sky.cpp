@@ -1,14 +1,20 @@
 #include "Sky.h"
+#include "AssetPack.h"
 #include "Color.h"
+#include "TextCache.h"
 
 #include <mist/Point.h>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <SDL_image.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <spdlog/spdlog.h>
 
@@ -53,21 +59,44 @@ void Sky::mainLoop(float fpsCap)
 {
     auto minFrameTimeMs = lround(1000.0f / fpsCap);
 
+    const auto ticksPerMs = static_cast<double>(SDL_GetPerformanceFrequency()) / 1000.0;
+    auto       elapsedMs = [=](Uint64 from, Uint64 to) {
+        return static_cast<double>(to - from) / ticksPerMs;
+    };
+
     auto lastUpdateTime = SDL_GetTicks();
+    auto frameStart = SDL_GetPerformanceCounter();
     while (activeScene->isAlive()) {
-        auto frameStartTime = SDL_GetTicks();
+        auto       frameStartTime = SDL_GetTicks();
+        const auto allocationsStart = allocationCount();
         activeScene->draw(renderer);
+        const auto drawEnd = SDL_GetPerformanceCounter();
+        const auto drawCalls = renderer.drawCalls;
+        renderer.drawCalls = 0;
         activeScene->processEvents();
 
         auto updateTime = SDL_GetTicks();
         auto dt = static_cast<float>(updateTime - lastUpdateTime) / 1000.0f; // NOLINT
         lastUpdateTime = updateTime;
         activeScene->update(dt);
+        AssetStreamer::shared().pump();
+        const auto updateEnd = SDL_GetPerformanceCounter();
+        const auto allocationsEnd = allocationCount();
 
         auto frameEndTime = SDL_GetTicks();
         auto frameTime = frameEndTime - frameStartTime;
         auto timeLeft = minFrameTimeMs - frameTime;
         if (timeLeft > 0) SDL_Delay(static_cast<Uint32>(timeLeft));
+
+        const auto nextFrameStart = SDL_GetPerformanceCounter();
+        frameStats.frame++;
+        frameStats.frameMs = elapsedMs(frameStart, nextFrameStart);
+        frameStats.drawMs = elapsedMs(frameStart, drawEnd);
+        frameStats.updateMs = elapsedMs(drawEnd, updateEnd);
+        frameStats.drawCalls = drawCalls;
+        frameStats.textures = Texture::getLiveCount();
+        frameStats.allocations = allocationsStart < 0 ? -1 : allocationsEnd - allocationsStart;
+        frameStart = nextFrameStart;
     }
 }
 
@@ -95,7 +124,8 @@ void Sky::createWindow(const char *name)
 
 auto Sky::loadFont(const char *file, int size) -> std::shared_ptr<Font>
 {
-    auto *font = TTF_OpenFont(file, size);
+    auto *rw = AssetPack::openMounted(file);
+    auto *font = rw != nullptr ? TTF_OpenFontRW(rw, 1, size) : TTF_OpenFont(file, size);
     if (!font) throw TTFError("open font");
     return std::make_shared<Font>(font);
 }
@@ -184,7 +214,8 @@ Surface &Surface::operator=(Surface &&other) noexcept
 
 Surface Surface::fromFile(const char *file)
 {
-    auto *tmp = IMG_Load(file);
+    auto *rw = AssetPack::openMounted(file);
+    auto *tmp = rw != nullptr ? IMG_Load_RW(rw, 1) : IMG_Load(file);
     if (tmp == nullptr) throw SDLError("Load image");
     return Surface {tmp};
 }
@@ -201,6 +232,7 @@ void Surface::saveToFile(const char *file)
 Texture::Texture(SDL_Texture *texture_, int width_, int height_)
     : texture(texture_), width(width_), height(height_)
 {
+    if (texture) liveCount++;
 }
 
 Texture::Texture(const Surface &surface) : width(surface.getWidth()), height(surface.getHeight())
@@ -209,12 +241,14 @@ Texture::Texture(const Surface &surface) : width(surface.getWidth()), height(sur
     if (texture == nullptr) {
         throw SDLError("Create texture from surface");
     }
+    liveCount++;
 }
 
 Texture::~Texture()
 {
     if (texture) {
         SDL_DestroyTexture(texture);
+        liveCount--;
     }
 }
 
@@ -227,6 +261,7 @@ Texture &Texture::operator=(Texture &&other) noexcept
 {
     if (texture) {
         SDL_DestroyTexture(texture);
+        liveCount--;
     }
     texture = other.texture;
     other.texture = nullptr;
@@ -240,11 +275,32 @@ void Texture::renderTo(Renderer &renderer, const SDL_Rect *src, const SDL_Rect *
                        const SDL_RendererFlip flip) const
 {
     SDL_RenderCopyEx(renderer, texture, src, dest, angle, nullptr, flip);
+    renderer.countDrawCalls();
 }
 
 // -----------------------------------------------------------------------------
 
-Font::Font(TTF_Font *font_) : font(font_)
+struct Font::GlyphAtlas {
+    struct Glyph {
+        bool     provided;
+        SDL_Rect rect;    ///< in the atlas texture
+        int      offsetX; ///< from the pen position to the left edge of rect
+        int      advance;
+    };
+
+    Texture                 texture;
+    std::array<Glyph, 256>  glyphs {};
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int>        indices;
+};
+
+namespace
+{
+std::atomic<std::uint64_t> nextFontId {1};
+constexpr std::size_t      measureCacheSize = 1024;
+} // namespace
+
+Font::Font(TTF_Font *font_) : font(font_), id(nextFontId++)
 {
 }
 
@@ -255,7 +311,7 @@ Font::~Font()
     }
 }
 
-Font::Font(Font &&other)
+Font::Font(Font &&other) : font(nullptr), id(0)
 {
     *this = std::move(other);
 }
@@ -267,9 +323,116 @@ Font &Font::operator=(Font &&other)
     }
     font = other.font;
     other.font = nullptr;
+    id = other.id;
+    atlas = std::move(other.atlas);
+    measureCache = std::move(other.measureCache);
     return *this;
 }
 
+Font::GlyphAtlas &Font::getAtlas() const
+{
+    if (atlas) return *atlas;
+
+    constexpr int atlasWidth = 512;
+    const auto    lineHeight = TTF_FontHeight(font);
+    const auto    white = SDL_Color {255, 255, 255, 255};
+
+    // All glyph surfaces are one line high, so they are packed in rows
+    std::vector<std::pair<Uint16, Surface>> rendered;
+    auto                                    newAtlas = std::make_unique<GlyphAtlas>();
+    SDL_Rect                                pen {0, 0, 0, 0};
+
+    for (Uint16 ch = 32; ch < 256; ch++) {
+        if (ch >= 127 && ch < 160) continue;
+        if (!TTF_GlyphIsProvided(font, ch)) continue;
+
+        int minX = 0, maxX = 0, minY = 0, maxY = 0, advance = 0;
+        if (TTF_GlyphMetrics(font, ch, &minX, &maxX, &minY, &maxY, &advance) < 0) continue;
+
+        auto &glyph = newAtlas->glyphs[ch];
+        glyph.provided = true;
+        glyph.offsetX = std::min(0, minX);
+        glyph.advance = advance;
+
+        SDL_Surface *surface = TTF_RenderGlyph_Blended(font, ch, white);
+        if (surface == nullptr) continue;
+        rendered.emplace_back(ch, Surface {surface});
+
+        if (pen.x + surface->w > atlasWidth) {
+            pen.x = 0;
+            pen.y += lineHeight;
+        }
+        glyph.rect = {pen.x, pen.y, surface->w, surface->h};
+        pen.x += surface->w;
+    }
+
+    Surface atlasSurface {atlasWidth, pen.y + lineHeight, 32};
+    for (auto &[ch, surface] : rendered) {
+        SDL_SetSurfaceBlendMode(surface.get(), SDL_BLENDMODE_NONE);
+        SDL_BlitSurface(surface.get(), nullptr, atlasSurface.get(), &newAtlas->glyphs[ch].rect);
+    }
+
+    newAtlas->texture = Texture {atlasSurface};
+    SDL_SetTextureBlendMode(newAtlas->texture.get(), SDL_BLENDMODE_BLEND);
+    atlas = std::move(newAtlas);
+    return *atlas;
+}
+
+int Font::drawText(Renderer &renderer, std::string_view text, int x, int y,
+                   const Color &color) const
+{
+    auto &a = getAtlas();
+    a.vertices.clear();
+    a.indices.clear();
+
+    const auto sdlColor = color.toSdl();
+    const auto scaleU = 1.0f / static_cast<float>(a.texture.getWidth());
+    const auto scaleV = 1.0f / static_cast<float>(a.texture.getHeight());
+
+    // Latin-1, matching renderSolid() and measure()
+    auto   penX = x;
+    Uint16 previous = 0;
+    for (const auto c : text) {
+        const auto  ch = static_cast<unsigned char>(c);
+        const auto &glyph = a.glyphs[ch];
+        if (!glyph.provided) continue;
+
+        if (previous != 0) penX += TTF_GetFontKerningSizeGlyphs(font, previous, ch);
+        previous = ch;
+        if (glyph.rect.w == 0) {
+            penX += glyph.advance;
+            continue;
+        }
+
+        const auto left = static_cast<float>(penX + glyph.offsetX);
+        const auto top = static_cast<float>(y);
+        const auto right = left + static_cast<float>(glyph.rect.w);
+        const auto bottom = top + static_cast<float>(glyph.rect.h);
+        const auto u0 = static_cast<float>(glyph.rect.x) * scaleU;
+        const auto v0 = static_cast<float>(glyph.rect.y) * scaleV;
+        const auto u1 = static_cast<float>(glyph.rect.x + glyph.rect.w) * scaleU;
+        const auto v1 = static_cast<float>(glyph.rect.y + glyph.rect.h) * scaleV;
+
+        const auto first = static_cast<int>(a.vertices.size());
+        a.vertices.push_back({{left, top}, sdlColor, {u0, v0}});
+        a.vertices.push_back({{right, top}, sdlColor, {u1, v0}});
+        a.vertices.push_back({{right, bottom}, sdlColor, {u1, v1}});
+        a.vertices.push_back({{left, bottom}, sdlColor, {u0, v1}});
+        for (const auto i : {0, 1, 2, 0, 2, 3})
+            a.indices.push_back(first + i);
+
+        penX += glyph.advance;
+    }
+
+    if (!a.indices.empty()) {
+        SDL_RenderGeometry(renderer, a.texture.get(), a.vertices.data(),
+                           static_cast<int>(a.vertices.size()), a.indices.data(),
+                           static_cast<int>(a.indices.size()));
+        renderer.countDrawCalls();
+    }
+    return penX - x;
+}
+
 Texture Font::renderSolid(const std::string &text, const Color &color) const
 {
     SDL_Surface *tmp = TTF_RenderText_Solid(font, text.c_str(), color.toSdl());
@@ -277,23 +440,68 @@ Texture Font::renderSolid(const std::string &text, const Color &color) const
     return Texture(Surface(tmp));
 }
 
-mist::Point2i Font::measure(const std::string text) const
+mist::Point2i Font::measure(std::string text) const
 {
+    if (auto it = measureCache.find(text); it != measureCache.end()) return it->second;
+
     mist::Point2i ret {0, 0};
     TTF_SizeText(font, text.c_str(), &ret.x, &ret.y);
+
+    if (measureCache.size() >= measureCacheSize) measureCache.clear();
+    measureCache.emplace(std::move(text), ret);
     return ret;
 }
 
+std::shared_ptr<const Texture> Font::renderCached(const std::string &text,
+                                                  const Color       &color) const
+{
+    return TextCache::shared().get(*this, text, color);
+}
+
+int Font::getStyle() const noexcept
+{
+    return TTF_GetFontStyle(font);
+}
+
 // -----------------------------------------------------------------------------
 
 void Scene::processEvents()
 {
-    SDL_Event event;
+    SDL_Event            event;
+    SDL_MouseMotionEvent motion {};
+    bool                 hasMotion = false;
+
+    // Motion is coalesced, but delivered before any button or wheel event that follows it
+    auto flushMotion = [&]() {
+        if (!hasMotion) return;
+        hasMotion = false;
+        onMouseMotion(motion);
+    };
 
     while (SDL_PollEvent(&event) != 0) {
         switch (event.type) {
         case SDL_QUIT: alive = false; break;
-        case SDL_KEYDOWN: onKeyDown(event.key); break;
+        case SDL_KEYDOWN:
+            if (!filterKeyDown(event.key)) onKeyDown(event.key);
+            break;
+        case SDL_MOUSEMOTION:
+            if (hasMotion) {
+                event.motion.xrel += motion.xrel;
+                event.motion.yrel += motion.yrel;
+            }
+            motion = event.motion;
+            hasMotion = true;
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            flushMotion();
+            onMouseButton(event.button);
+            break;
+        case SDL_MOUSEWHEEL:
+            flushMotion();
+            onMouseWheel(event.wheel);
+            break;
         }
     }
+    flushMotion();
 }
@@ -8,7 +8,19 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace sky
@@ -33,11 +45,29 @@ public:
     void clear();
     void present();
 
+    /// @brief Count draw calls made directly with SDL, to include them in FrameStats
+    void countDrawCalls(int n = 1) noexcept { drawCalls += n; }
+
 private:
     friend class Sky;
     SDL_Renderer *renderer = nullptr;
+    int           drawCalls = 0;
+};
+
+/// @brief Timing and counters of the last complete frame of Sky::mainLoop()
+struct FrameStats {
+    std::uint64_t frame {0};
+    double        frameMs {0}; ///< from the start of the frame to the start of the next one
+    double        drawMs {0};  ///< including Renderer::present(), which may wait for vsync
+    double        updateMs {0}; ///< events and Scene::update()
+    int           drawCalls {0}; ///< texture copies, geometry batches and fills done by sky
+    int           textures {0};  ///< live Texture objects
+    std::int64_t  allocations {-1}; ///< -1 unless built with SKY_COUNT_ALLOCATIONS
 };
 
+/// @brief Heap allocations since start, -1 unless built with SKY_COUNT_ALLOCATIONS
+std::int64_t allocationCount() noexcept;
+
 // -----------------------------------------------------------------------------
 
 class Texture;
@@ -62,11 +92,14 @@ public:
 
     void setScene(Scene *scene);
 
+    [[nodiscard]] const FrameStats &getFrameStats() const noexcept { return frameStats; }
+
     static std::shared_ptr<Font>    loadFont(const char *file, int size);
 
 private:
     static std::unique_ptr<Sky> instance;
     Scene                      *activeScene = nullptr;
+    FrameStats                  frameStats;
 
     int width;
     int height;
@@ -101,7 +134,7 @@ public:
     void saveToFile(const char *file);
 
 private:
-    SDL_Surface *surface;
+    SDL_Surface *surface {nullptr};
 };
 
 // -----------------------------------------------------------------------------
@@ -127,7 +160,12 @@ public:
     void renderTo(Renderer &renderer, const SDL_Rect *src, const SDL_Rect *dest, double angle = 0,
                   const SDL_RendererFlip flip = SDL_FLIP_NONE) const;
 
+    /// @brief Number of Texture objects holding an SDL texture
+    [[nodiscard]] static int getLiveCount() noexcept { return liveCount; }
+
 private:
+    static inline int liveCount = 0;
+
     SDL_Texture *texture {nullptr};
     int          width {0};
     int          height {0};
@@ -147,10 +185,39 @@ public:
     Font &operator=(Font &&other);
 
     Texture       renderSolid(const std::string &text, const Color &color) const;
-    mist::Point2i measure(const std::string text) const;
+    mist::Point2i measure(std::string text) const;
+
+    /// @brief Like renderSolid(), but shared through TextCache::shared()
+    std::shared_ptr<const Texture> renderCached(const std::string &text,
+                                                const Color       &color) const;
+
+    /// @brief Unique for every font opened during the run, used as a cache key
+    [[nodiscard]] std::uint64_t getId() const noexcept { return id; }
+    [[nodiscard]] int           getStyle() const noexcept;
+
+    /**
+     * @brief Draw text without creating any textures
+     *
+     * On first use, all printable Latin-1 glyphs are rasterized in white into a single atlas
+     * texture. Text is then drawn as one batch of textured quads, tinted with color, with
+     * kerning applied. Characters not provided by the font are skipped.
+     *
+     * @return width of the drawn text
+     */
+    int drawText(Renderer &renderer, std::string_view text, int x, int y,
+                 const Color &color) const;
 
 private:
-    TTF_Font *font;
+    struct GlyphAtlas;
+
+    TTF_Font                           *font;
+    std::uint64_t                       id;
+    mutable std::unique_ptr<GlyphAtlas> atlas;
+
+    /// Results of measure(); cleared when full, texts measured often are quickly back
+    mutable std::unordered_map<std::string, mist::Point2i> measureCache;
+
+    GlyphAtlas &getAtlas() const;
 };
 
 // -----------------------------------------------------------------------------
@@ -179,12 +246,198 @@ protected:
     virtual void onUpdate(float) {}
     virtual void onKeyDown(const SDL_KeyboardEvent &) {}
 
+    /// @brief Engine-level hotkeys, checked before onKeyDown(); return true to consume the key
+    virtual bool filterKeyDown(const SDL_KeyboardEvent &) { return false; }
+
+    /// @brief Called at most once per frame, with the last position and the summed motion
+    virtual void onMouseMotion(const SDL_MouseMotionEvent &) {}
+    virtual void onMouseButton(const SDL_MouseButtonEvent &) {}
+    virtual void onMouseWheel(const SDL_MouseWheelEvent &) {}
+
 private:
     bool alive {true};
 };
 
 // -----------------------------------------------------------------------------
 
+/// @brief Estimated memory used by a resource, for ResourceCache
+std::size_t resourceBytes(const Texture &texture) noexcept;
+std::size_t resourceBytes(const Font &font) noexcept;
+
+template <class T> std::size_t resourceBytes(const T &) noexcept
+{
+    return 0;
+}
+
+struct ResourceCacheStats {
+    std::size_t   bytes {0}; ///< including pinned entries
+    std::size_t   pinnedBytes {0};
+    std::size_t   entries {0};
+    std::uint64_t evictions {0};
+};
+
+/**
+ * @brief Keeps recently used resources loaded, within a memory budget
+ *
+ * Res only holds a weak reference, so a resource is released as soon as nothing uses it,
+ * and loaded again on the next get(), e.g. in the next scene. Every Res::get() retains the
+ * resource here, and the least recently used resources are released when the total of
+ * their estimated sizes is over budget. Pinned resources are never released, but count
+ * toward the budget. The most recently used resource always stays, even if it alone is over
+ * budget. A released resource stays valid for as long as someone holds it.
+ *
+ * Not thread-safe; use from the main thread only.
+ */
+class ResourceCache
+{
+public:
+    explicit ResourceCache(std::size_t budgetBytes = 64 * 1024 * 1024);
+
+    /// @brief The cache used by Res
+    static ResourceCache &shared();
+
+    /// @brief Add or update an entry, and mark it as most recently used
+    void retain(const void *key, const std::shared_ptr<const void> &object, std::size_t bytes);
+
+    void pin(const void *key, bool enable);
+    void release(const void *key);
+
+    void setBudget(std::size_t bytes);
+
+    /// @brief Release all but pinned resources
+    void clear();
+
+    [[nodiscard]] const ResourceCacheStats &getStats() const noexcept { return stats; }
+
+private:
+    struct Entry {
+        const void                 *key;
+        std::shared_ptr<const void> object;
+        std::size_t                 bytes;
+        bool                        pinned;
+    };
+
+    using Entries = std::list<Entry>;
+
+    std::size_t                                         budget;
+    Entries                                             lru;    ///< most recent first
+    Entries                                             pinned; ///< never evicted
+    std::unordered_map<const void *, Entries::iterator> index;
+    ResourceCacheStats                                  stats;
+
+    void evict();
+    void erase(Entries::iterator entry);
+};
+
+// -----------------------------------------------------------------------------
+
+class StreamJob;
+using SharedStreamJob = std::shared_ptr<StreamJob>;
+
+/**
+ * @brief Decodes assets on a pool of worker threads, and uploads them on the main thread
+ *
+ * Jobs are decoded in order of priority, highest first. Decoded jobs wait for pump(), called
+ * by Sky::mainLoop() every frame, which uploads them, highest priority first, until the
+ * upload time budget of the frame is used up. At least one job is uploaded per pump().
+ *
+ * Worker threads are started on the first submit().
+ */
+class AssetStreamer
+{
+public:
+    /// @brief Runs on a worker thread; must not use the renderer
+    using Decode = std::function<Surface()>;
+
+    /// @brief Runs on the main thread, with the decoded surface
+    using Upload = std::function<void(Surface &&)>;
+
+    /// @arg threads number of workers; 0 - one less than the number of cores, at least one
+    explicit AssetStreamer(int threads = 0);
+    ~AssetStreamer();
+    AssetStreamer(const AssetStreamer &) = delete;
+    AssetStreamer(AssetStreamer &&) = delete;
+    AssetStreamer &operator=(const AssetStreamer &) = delete;
+    AssetStreamer &operator=(AssetStreamer &&) = delete;
+
+    /// @brief The streamer used by Res::request() and Sky::mainLoop()
+    static AssetStreamer &shared();
+
+    SharedStreamJob submit(int priority, Decode decode, Upload upload);
+
+    /// @brief Decode a job sooner, if it is still queued; priorities never decrease
+    void raise(const SharedStreamJob &job, int priority);
+
+    /// @brief Upload decoded jobs, on the main thread
+    /// @return number of jobs uploaded
+    int pump();
+
+    void setUploadBudget(double milliseconds) noexcept { uploadBudgetMs = milliseconds; }
+
+    /// @brief Jobs not uploaded yet
+    [[nodiscard]] int getPending() const noexcept { return pending.load(); }
+
+private:
+    struct Entry {
+        int             priority;
+        std::uint64_t   sequence;
+        SharedStreamJob job;
+
+        bool operator<(const Entry &other) const noexcept
+        {
+            // Highest priority first, then first submitted
+            return priority != other.priority ? priority < other.priority
+                                              : sequence > other.sequence;
+        }
+    };
+
+    int                          numThreads;
+    double                       uploadBudgetMs {2.0};
+    std::vector<std::thread>     workers;
+    std::mutex                   mutex;
+    std::condition_variable      wake;
+    std::priority_queue<Entry>   queue; ///< may hold stale entries of raised jobs
+    std::vector<SharedStreamJob> decoded;
+    std::uint64_t                sequence {0};
+    std::atomic<int>             pending {0};
+    bool                         stopping {false};
+
+    void work();
+};
+
+/// @brief A job of AssetStreamer
+class StreamJob
+{
+public:
+    /// @brief Uploaded, or failed
+    [[nodiscard]] bool isDone() const noexcept { return state.load() >= Done; }
+    [[nodiscard]] bool hasFailed() const noexcept { return state.load() == Failed; }
+
+private:
+    friend class AssetStreamer;
+
+    enum State { Queued, Decoding, Decoded, Done, Failed };
+
+    std::atomic<int>      state {Queued};
+    int                   priority;
+    AssetStreamer::Decode decode;
+    AssetStreamer::Upload upload;
+    Surface               surface {nullptr};
+    std::exception_ptr    error;
+};
+
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief A shared resource, loaded on first use and released when no longer used
+ *
+ * Recently used resources are kept loaded by ResourceCache::shared(), even when unused.
+ *
+ * By default get() loads synchronously. If the Loader can decode to a Surface off the main
+ * thread, request() streams the resource instead: it returns a placeholder right away, an
+ * empty object which is filled in when the upload is done. get() returns the same object
+ * until then, so holding it from the start works.
+ */
 template <class T, class Loader> class Res
 {
 public:
@@ -196,10 +449,33 @@ public:
 
     bool isLoaded() const { return !res.expired(); }
 
+    /// @brief Loaded, and not a placeholder of a request() in progress
+    bool isReady() const
+    {
+        return isLoaded() && (job == nullptr || (job->isDone() && !job->hasFailed()));
+    }
+
     operator std::shared_ptr<T>() const { return get(); }
 
     std::shared_ptr<T> get() const
     {
+        if (requested) {
+            if (!job->isDone()) return requested;
+
+            // Kept until now, in case nobody held the result of request()
+            auto current = std::move(requested);
+            const auto failed = job->hasFailed();
+            job.reset();
+            if (!failed) {
+                ResourceCache::shared().retain(this, current, resourceBytes(*current));
+                return current;
+            }
+
+            // The placeholder stays empty; load synchronously below, which reports the error
+            ResourceCache::shared().release(this);
+            res.reset();
+        }
+
         std::shared_ptr<T> current = res.lock();
         if (!current) {
             if constexpr (std::is_same_v<Arg, nullptr_t>)
@@ -208,12 +484,59 @@ public:
                 current = Loader {}(loaderArg);
             res = current;
         }
+        ResourceCache::shared().retain(this, current, resourceBytes(*current));
         return current;
     }
 
+    /// @brief Load, and keep loaded regardless of the ResourceCache budget
+    void pin() const
+    {
+        get();
+        ResourceCache::shared().pin(this, true);
+    }
+
+    /// @brief Let ResourceCache release the resource again when over budget
+    void unpin() const { ResourceCache::shared().pin(this, false); }
+
+    /**
+     * @brief Start loading in the background with AssetStreamer::shared()
+     *
+     * Calling again while queued raises the priority. If loading fails, the next get()
+     * tries again synchronously, and throws the error.
+     *
+     * @return the resource if loaded, otherwise a placeholder filled in when loaded
+     */
+    std::shared_ptr<T> request(int priority = 0) const
+        requires requires(Arg a, T &t, Surface &&s) {
+            Loader::decode(a);
+            Loader::placeholder();
+            Loader::upload(t, std::move(s));
+        }
+    {
+        if (requested) {
+            AssetStreamer::shared().raise(job, priority);
+            return requested;
+        }
+        if (auto current = res.lock()) return current;
+
+        auto target = Loader::placeholder();
+        res = target;
+        requested = target;
+        ResourceCache::shared().retain(this, target, 0);
+        job = AssetStreamer::shared().submit(
+            priority, [arg = loaderArg]() { return Loader::decode(arg); },
+            [this, target](Surface &&surface) {
+                Loader::upload(*target, std::move(surface));
+                ResourceCache::shared().retain(this, target, resourceBytes(*target));
+            });
+        return target;
+    }
+
 protected:
-    const Arg                loaderArg;
-    mutable std::weak_ptr<T> res;
+    const Arg                  loaderArg;
+    mutable std::weak_ptr<T>   res;
+    mutable std::shared_ptr<T> requested; ///< placeholder, until get() after the upload
+    mutable SharedStreamJob    job;
 };
 
 struct TextureLoader {
@@ -223,6 +546,10 @@ struct TextureLoader {
     {
         return std::make_shared<Texture>(Surface::fromFile(source));
     }
+
+    static Surface                  decode(const char *source) { return Surface::fromFile(source); }
+    static std::shared_ptr<Texture> placeholder() { return std::make_shared<Texture>(); }
+    static void upload(Texture &target, Surface &&surface) { target = Texture {surface}; }
 };
 
 struct FontSpec {
@@ -1,7 +1,10 @@
 #include "SkyEngine.h"
+#include "PerfHud.h"
 #include "Sky.h"
+#include "SkyUi.h"
 
 #include <SDL2/SDL.h>
+#include <stdexcept>
 
 #include <spdlog/spdlog.h>
 
@@ -41,6 +44,55 @@ void EngineScene::addUi(SharedObject o)
     layers[LayerId::UI].objects.emplace_back(std::move(o));
 }
 
+void EngineScene::addUiInput(std::shared_ptr<Ui> ui)
+{
+    uiInputs.insert(uiInputs.begin(), std::move(ui));
+}
+
+void EngineScene::enablePerfHud(std::shared_ptr<Font> font, SDL_Scancode toggleKey)
+{
+    perfHud = std::make_shared<PerfHud>(std::move(font));
+    perfHudKey = toggleKey;
+}
+
+bool EngineScene::filterKeyDown(const SDL_KeyboardEvent &event)
+{
+    if (perfHud == nullptr || event.keysym.scancode != perfHudKey || event.repeat != 0)
+        return false;
+    perfHudVisible = !perfHudVisible;
+    return true;
+}
+
+void EngineScene::onMouseMotion(const SDL_MouseMotionEvent &event)
+{
+    // Every Ui tracks the pointer, so hover leaves a Ui covered by another one
+    bool covered = false;
+    for (auto &ui : uiInputs) {
+        if (covered)
+            ui->handleMouseLeave();
+        else
+            covered = ui->handleMouseMotion(event);
+    }
+}
+
+void EngineScene::onMouseButton(const SDL_MouseButtonEvent &event)
+{
+    if (event.type == SDL_MOUSEBUTTONUP) {
+        for (auto &ui : uiInputs)
+            if (ui->isCapturing() && ui->handleMouseButton(event)) return;
+    }
+    for (auto &ui : uiInputs)
+        if (ui->handleMouseButton(event)) return;
+    onWorldMouseButton(event);
+}
+
+void EngineScene::onMouseWheel(const SDL_MouseWheelEvent &event)
+{
+    for (auto &ui : uiInputs)
+        if (ui->handleMouseWheel(event)) return;
+    onWorldMouseWheel(event);
+}
+
 void EngineScene::onDraw(Renderer &renderer)
 {
     renderer.setDrawColor(sky::Color {0, 0, 0, 255});
@@ -53,6 +105,11 @@ void EngineScene::onDraw(Renderer &renderer)
     }
 
     onPostDraw(renderer);
+
+    if (perfHud) {
+        perfHud->record(Sky::getInstance().getFrameStats());
+        if (perfHudVisible) perfHud->draw(renderer, 8, 8, 0);
+    }
     renderer.present();
 }
 
@@ -117,6 +174,86 @@ void Sprite::draw(Renderer &renderer, int x, int y, double angle)
 
 // -----------------------------------------------------------------------------
 
+SharedAnimationClip AnimationClip::fromGrid(std::shared_ptr<Texture> texture, int frameWidth,
+                                            int frameHeight, int firstFrame, int count,
+                                            float frameDuration, bool loop)
+{
+    if (frameWidth <= 0 || frameHeight <= 0) {
+        throw std::runtime_error("Animation clip: frame size must be positive");
+    }
+    if (firstFrame < 0 || count <= 0) throw std::runtime_error("Animation clip: invalid frames");
+    if (frameDuration <= 0) {
+        throw std::runtime_error("Animation clip: frame duration must be positive");
+    }
+
+    auto       clip = std::make_shared<AnimationClip>();
+    const auto framesPerRow = texture->getWidth() / frameWidth;
+    if (framesPerRow <= 0) throw std::runtime_error("Animation clip: frame wider than texture");
+
+    clip->frames.reserve(static_cast<size_t>(count));
+    for (int i = firstFrame; i < firstFrame + count; i++) {
+        const auto row = i / framesPerRow;
+        const auto col = i % framesPerRow;
+        clip->frames.emplace_back(
+            SDL_Rect {col * frameWidth, row * frameHeight, frameWidth, frameHeight});
+    }
+    clip->texture = std::move(texture);
+    clip->frameDuration = frameDuration;
+    clip->loop = loop;
+    return clip;
+}
+
+AnimatedSprite::AnimatedSprite(SharedAnimationClip clip_) : clip(std::move(clip_))
+{
+}
+
+void AnimatedSprite::setClip(SharedAnimationClip clip_)
+{
+    clip = std::move(clip_);
+    restart();
+}
+
+void AnimatedSprite::restart() noexcept
+{
+    time = 0;
+    frame = 0;
+    finished = false;
+}
+
+void AnimatedSprite::update(float dt) noexcept
+{
+    if (finished || clip == nullptr || clip->frames.empty() || clip->frameDuration <= 0) return;
+
+    time += dt;
+    if (time < clip->frameDuration) return;
+
+    // Skip whole frames at once, in case dt is much longer than a frame
+    const auto steps = static_cast<int>(time / clip->frameDuration);
+    time -= static_cast<float>(steps) * clip->frameDuration;
+
+    const auto numFrames = static_cast<int>(clip->frames.size());
+    frame += steps;
+    if (frame < numFrames) return;
+
+    if (clip->loop) {
+        frame %= numFrames;
+    } else {
+        frame = numFrames - 1;
+        finished = true;
+    }
+}
+
+void AnimatedSprite::draw(Renderer &renderer, int x, int y, double angle)
+{
+    if (clip == nullptr || clip->frames.empty()) return;
+
+    const auto &src = clip->frames[static_cast<size_t>(frame)];
+    SDL_Rect    destRect {x - src.w / 2, y - src.h / 2, src.w, src.h};
+    clip->texture->renderTo(renderer, &src, &destRect, angle, SDL_FLIP_NONE);
+}
+
+// -----------------------------------------------------------------------------
+
 SharedObject Object::from(SharedDrawable d)
 {
     return std::make_shared<Object>(std::move(d));
@@ -17,6 +17,8 @@ namespace sky
 
 class Object;
 class Drawable;
+class Ui;
+class PerfHud;
 
 using SharedObject = std::shared_ptr<Object>;
 using SharedDrawable = std::shared_ptr<Drawable>;
@@ -79,6 +81,8 @@ public:
 
     void draw(Renderer &renderer, int x, int y, double angle) override;
 
+    [[nodiscard]] const std::shared_ptr<Texture> &getTexture() const noexcept { return texture; }
+
 private:
     std::shared_ptr<Texture> texture;
     int                      width;
@@ -87,6 +91,62 @@ private:
 
 using SharedSprite = std::shared_ptr<Sprite>;
 
+inline std::size_t resourceBytes(const Sprite &sprite) noexcept
+{
+    return resourceBytes(*sprite.getTexture());
+}
+
+/**
+ * @brief A sequence of frames on a single sprite sheet texture
+ *
+ * Clips are immutable once built and meant to be shared between any number of
+ * AnimatedSprite instances.
+ */
+struct AnimationClip {
+    std::shared_ptr<Texture> texture;
+    std::vector<SDL_Rect>    frames;
+    float                    frameDuration {0.1f};
+    bool                     loop {true};
+
+    /**
+     * @brief Build a clip from a grid of equally sized frames
+     *
+     * Frames are numbered the same way as Tileset tiles: from 0 in positive X direction,
+     * wrapping to the next row at the texture edge.
+     */
+    static std::shared_ptr<const AnimationClip> fromGrid(std::shared_ptr<Texture> texture,
+                                                         int frameWidth, int frameHeight,
+                                                         int firstFrame, int count,
+                                                         float frameDuration, bool loop = true);
+};
+
+using SharedAnimationClip = std::shared_ptr<const AnimationClip>;
+
+/// @brief A Drawable that plays an AnimationClip
+/// Call update() once per frame to advance the animation.
+class AnimatedSprite : public Drawable
+{
+public:
+    explicit AnimatedSprite(SharedAnimationClip clip);
+
+    void setClip(SharedAnimationClip clip);
+    void restart() noexcept;
+    void update(float dt) noexcept;
+
+    [[nodiscard]] int  getFrame() const noexcept { return frame; }
+    [[nodiscard]] bool isFinished() const noexcept { return finished; }
+
+    void draw(Renderer &renderer, int x, int y, double angle) override;
+
+private:
+    SharedAnimationClip clip;
+    float               time {0};
+    int                 frame {0};
+    bool                finished {false};
+};
+
+using SharedAnimatedSprite = std::shared_ptr<AnimatedSprite>;
+
 // -----------------------------------------------------------------------------
 
 struct RenderLayer {
@@ -110,14 +170,33 @@ public:
     void add(SharedObject d);
     void addUi(SharedObject d);
 
+    /// @brief Route mouse events to a Ui, before those added earlier
+    void addUiInput(std::shared_ptr<Ui> ui);
+
+    /// @brief Show a PerfHud in the top left corner, toggled with toggleKey, hidden at first
+    void enablePerfHud(std::shared_ptr<Font> font, SDL_Scancode toggleKey = SDL_SCANCODE_F3);
+
     static SharedSprite loadSprite(const char *file);
 
 protected:
     void         onDraw(Renderer &renderer) override;
     virtual void onPostDraw(Renderer &) {};
 
+    bool filterKeyDown(const SDL_KeyboardEvent &event) override;
+    void onMouseMotion(const SDL_MouseMotionEvent &event) override;
+    void onMouseButton(const SDL_MouseButtonEvent &event) override;
+    void onMouseWheel(const SDL_MouseWheelEvent &event) override;
+
+    /// @brief Mouse events outside of all input Uis
+    virtual void onWorldMouseButton(const SDL_MouseButtonEvent &) {}
+    virtual void onWorldMouseWheel(const SDL_MouseWheelEvent &) {}
+
 private:
-    std::array<RenderLayer, 2> layers;
+    std::array<RenderLayer, 2>       layers;
+    std::vector<std::shared_ptr<Ui>> uiInputs; ///< topmost first
+    std::shared_ptr<PerfHud>         perfHud;
+    SDL_Scancode                     perfHudKey {SDL_SCANCODE_UNKNOWN};
+    bool                             perfHudVisible {false};
 };
 
 struct SpriteLoader {
@@ -127,6 +206,21 @@ struct SpriteLoader {
     {
         return EngineScene::loadSprite(source);
     }
+
+    static Surface decode(const char *source) { return Surface::fromFile(source); }
+
+    static std::shared_ptr<Sprite> placeholder()
+    {
+        return std::make_shared<Sprite>(std::make_shared<Texture>());
+    }
+
+    /// Fills the placeholder texture in place, so holders of getTexture() see it too
+    static void upload(Sprite &target, Surface &&surface)
+    {
+        auto texture = target.getTexture();
+        *texture = Texture {surface};
+        target = Sprite {std::move(texture)};
+    }
 };
 
 using SpriteRes = Res<Sprite, SpriteLoader>;
@@ -2,27 +2,128 @@
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
+#include <algorithm>
+#include <numeric>
 #include <spdlog/spdlog.h>
 
 using namespace sky;
 using namespace mist;
 
+namespace
+{
 
+/// Wheel scrolling of a ListView without a fixed row height, in pixels per line
+constexpr int WheelLinePixels = 16;
+constexpr int WheelLines = 3;
 
-void Widget::draw(Ui &context, Renderer &renderer, int x, int y, double)
+bool isWithin(const UiDrawable *drawable, const UiDrawable *ancestor) noexcept
 {
-    if (!valid) {
-        texture = render(context);
-        valid = true;
+    for (; drawable != nullptr; drawable = drawable->getParent())
+        if (drawable == ancestor) return true;
+    return false;
+}
+
+/// Enter drawable and its ancestors, outermost first, except those containing previous
+void enter(UiDrawable *drawable, const UiDrawable *previous)
+{
+    if (drawable == nullptr || isWithin(previous, drawable)) return;
+    enter(drawable->getParent(), previous);
+    drawable->onMouseEnter();
+}
+
+} // namespace
+
+void UiDrawable::requestLayout() noexcept
+{
+    needsMeasure = true;
+    for (auto *p = parent; p != nullptr && !p->hasDirtyChildren; p = p->parent)
+        p->hasDirtyChildren = true;
+    requestRedraw();
+}
+
+void UiDrawable::requestRedraw() noexcept
+{
+    needsRedraw = true;
+    for (auto *p = parent; p != nullptr && !p->hasRedrawChildren; p = p->parent)
+        p->hasRedrawChildren = true;
+}
+
+void UiDrawable::collectRedraws(int x, int y, std::vector<UiRedraw> &out)
+{
+    if (needsRedraw) {
+        // Drawing this element draws all of its children too
+        out.push_back({this, x, y});
+        clearRedraws();
+        return;
+    }
+
+    if (!hasRedrawChildren) return;
+    hasRedrawChildren = false;
+    for (auto *child : children)
+        child->collectRedraws(x + child->offsetX, y + child->offsetY, out);
+}
+
+void UiDrawable::clearRedraws() noexcept
+{
+    needsRedraw = false;
+    if (!hasRedrawChildren) return;
+
+    hasRedrawChildren = false;
+    for (auto *child : children)
+        child->clearRedraws();
+}
+
+bool UiDrawable::updateLayout(const Ui &context)
+{
+    if (!needsMeasure && !hasDirtyChildren) return false;
+
+    bool childResized = false;
+    if (hasDirtyChildren) {
+        hasDirtyChildren = false;
+        for (auto *child : children)
+            childResized |= child->updateLayout(context);
     }
+    if (!needsMeasure && !childResized) return false;
+
+    needsMeasure = false;
+    needsRedraw = true;
+    const auto oldWidth = width;
+    const auto oldHeight = height;
+    measure(context);
+    layout();
+    return width != oldWidth || height != oldHeight;
+}
+
+void UiDrawable::addChild(UiDrawable *child)
+{
+    children.emplace_back(child);
+    child->parent = this;
+    child->requestLayout();
+    requestLayout();
+}
 
+/* -------------------------------------------------------------------------- */
+
+void Widget::draw(Ui &context, Renderer &renderer, int x, int y, double)
+{
     SDL_Rect destRect {x, y, width, height};
     SDL_SetRenderDrawColor(renderer, backgroundColor.r, backgroundColor.g, backgroundColor.b,
                            backgroundColor.a);
     SDL_RenderFillRect(renderer, &destRect);
-    destRect.w = texture.getWidth();
-    destRect.h = texture.getHeight();
-    texture.renderTo(renderer, nullptr, &destRect);
+    renderer.countDrawCalls();
+    drawContent(context, renderer, x, y);
+}
+
+void Widget::drawContent(Ui &context, Renderer &renderer, int x, int y)
+{
+    if (!valid) {
+        texture = render(context);
+        valid = true;
+    }
+    if (texture == nullptr) return;
+
+    SDL_Rect destRect {x, y, texture->getWidth(), texture->getHeight()};
+    texture->renderTo(renderer, nullptr, &destRect);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -41,14 +142,14 @@ void Label::measure(const Ui &context)
 {
     if (font == nullptr) font = context.getDefaultFont();
     Point2i dim = font->measure(text);
-    if (width == 0) width = dim.x;
-    if (height == 0) height = dim.y;
+    width = fixedWidth != 0 ? fixedWidth : dim.x;
+    height = fixedHeight != 0 ? fixedHeight : dim.y;
 }
 
-Texture Label::render(Ui &context)
+void Label::drawContent(Ui &context, Renderer &renderer, int x, int y)
 {
     if (font == nullptr) font = context.getDefaultFont();
-    return font->renderSolid(text.empty() ? std::string(" "): text, foregroundColor);
+    font->drawText(renderer, text, x, y, foregroundColor);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -61,17 +162,43 @@ LinearLayout::LinearLayout(int width_, int height_) noexcept
 
 LinearLayout &LinearLayout::operator+=(UiDrawable *d)
 {
-    contents.emplace_back(d);
+    addChild(d);
     return *this;
 }
 
 void LinearLayout::draw(Ui &context, Renderer &renderer, int x0, int y0, double angle)
 {
-    int x = x0;
-    int y = y0;
+    for (auto i : children)
+        i->draw(context, renderer, x0 + i->offsetX, y0 + i->offsetY, angle);
+}
 
-    for (auto i : contents) {
-        i->draw(context, renderer, x, y, angle);
+void LinearLayout::measure(const Ui &)
+{
+    int w = 0;
+    int h = 0;
+
+    for (auto i : children) {
+        if (vertical) {
+            w = std::max(w, i->width);
+            h += i->height;
+        } else {
+            w += i->width;
+            h = std::max(h, i->height);
+        }
+    }
+
+    width = w;
+    height = h;
+}
+
+void LinearLayout::layout()
+{
+    int x = 0;
+    int y = 0;
+
+    for (auto i : children) {
+        i->offsetX = x;
+        i->offsetY = y;
 
         if (vertical)
             y += i->height;
@@ -80,22 +207,284 @@ void LinearLayout::draw(Ui &context, Renderer &renderer, int x0, int y0, double
     }
 }
 
-void LinearLayout::measure(const Ui &context)
+/* -------------------------------------------------------------------------- */
+
+ListView::ListView(int width_, int height_, std::shared_ptr<ListAdapter> adapter_, int rowHeight)
+    : adapter(std::move(adapter_)), fixedRowHeight(rowHeight)
 {
-    int w = 0;
-    int h = 0;
+    width = width_;
+    height = height_;
+    notifyDataChanged();
+}
 
-    for (auto i : contents) {
-        i->measure(context);
+void ListView::measure(const Ui &)
+{
+    // Fixed size, rows are measured when bound
+}
 
-        if (vertical)
-            h += i->height;
+void ListView::notifyDataChanged()
+{
+    count = adapter->getCount();
+
+    if (fixedRowHeight == 0) {
+        rowOffsets.resize(static_cast<std::size_t>(count) + 1);
+        rowOffsets[0] = 0;
+        for (int i = 0; i < count; i++) {
+            rowOffsets[static_cast<std::size_t>(i) + 1] =
+                rowOffsets[static_cast<std::size_t>(i)] + adapter->getRowHeight(i);
+        }
+    }
+
+    // Every visible row needs binding again
+    for (auto &row : rows)
+        recycled.push_back(std::move(row.widget));
+    rows.clear();
+    changedItems.clear();
+
+    scrollTo(scroll);
+    requestRedraw();
+}
+
+void ListView::notifyItemChanged(int index)
+{
+    changedItems.push_back(index);
+    requestRedraw();
+}
+
+int ListView::getContentHeight() const noexcept
+{
+    return fixedRowHeight != 0 ? count * fixedRowHeight : rowOffsets.back();
+}
+
+int ListView::getItemTop(int index) const noexcept
+{
+    return fixedRowHeight != 0 ? index * fixedRowHeight
+                               : rowOffsets[static_cast<std::size_t>(index)];
+}
+
+int ListView::itemAt(int contentY) const noexcept
+{
+    if (contentY < 0 || contentY >= getContentHeight()) return -1;
+    if (fixedRowHeight != 0) return contentY / fixedRowHeight;
+
+    // Last item starting at or above contentY
+    const auto it = std::upper_bound(rowOffsets.begin(), rowOffsets.end(), contentY);
+    return static_cast<int>(it - rowOffsets.begin()) - 1;
+}
+
+void ListView::scrollTo(int offset)
+{
+    const auto clamped = std::clamp(offset, 0, std::max(0, getContentHeight() - height));
+    if (clamped == scroll) return;
+    scroll = clamped;
+    requestRedraw();
+}
+
+void ListView::scrollToItem(int index)
+{
+    if (index < 0 || index >= count) return;
+    scrollTo(getItemTop(index));
+}
+
+bool ListView::onMouseButton(const SDL_MouseButtonEvent &event, int x, int y)
+{
+    // Rows are those of the last draw; an item scrolled in since then has no row yet
+    const auto index = itemAt(scroll + y);
+    if (index < 0 || rows.empty() || index < rows.front().index || index > rows.back().index)
+        return false;
+
+    auto &row = rows[static_cast<std::size_t>(index - rows.front().index)];
+    return row.widget->onMouseButton(event, x, scroll + y - getItemTop(index));
+}
+
+bool ListView::onMouseWheel(const SDL_MouseWheelEvent &event)
+{
+    const auto lines = event.direction == SDL_MOUSEWHEEL_FLIPPED ? -event.y : event.y;
+    const auto step = WheelLines * (fixedRowHeight != 0 ? fixedRowHeight : WheelLinePixels);
+    const auto oldScroll = scroll;
+    scrollBy(-lines * step);
+    return scroll != oldScroll;
+}
+
+void ListView::bind(const Ui &context, Row &row)
+{
+    adapter->bindRow(*row.widget, row.index);
+    row.widget->updateLayout(context);
+    row.widget->width = width;
+    row.widget->height = getItemTop(row.index + 1) - getItemTop(row.index);
+}
+
+void ListView::updateRows(const Ui &context)
+{
+    auto first = itemAt(scroll);
+    auto last = itemAt(std::min(scroll + height, getContentHeight()) - 1);
+    if (first < 0 || last < first) {
+        first = 0;
+        last = -1;
+    }
+
+    // Recycle rows that left the view first, so they can be reused right away
+    nextRows.clear();
+    for (auto &row : rows) {
+        if (row.index < first || row.index > last)
+            recycled.push_back(std::move(row.widget));
         else
-            w += i->width;
+            nextRows.push_back(std::move(row));
     }
+    rows.swap(nextRows);
 
-    width = w;
-    height = h;
+    // Rows stay ordered by item, so the kept rows are a contiguous run
+    nextRows.clear();
+    auto kept = rows.begin();
+    for (int i = first; i <= last; i++) {
+        if (kept != rows.end() && kept->index == i) {
+            nextRows.push_back(std::move(*kept++));
+            continue;
+        }
+
+        Row row {i, nullptr};
+        if (!recycled.empty()) {
+            row.widget = std::move(recycled.back());
+            recycled.pop_back();
+        } else {
+            row.widget = adapter->createRow();
+        }
+        bind(context, row);
+        nextRows.push_back(std::move(row));
+    }
+    rows.swap(nextRows);
+
+    for (const auto index : changedItems) {
+        if (rows.empty() || index < rows.front().index || index > rows.back().index) continue;
+        bind(context, rows[static_cast<std::size_t>(index - rows.front().index)]);
+    }
+    changedItems.clear();
+}
+
+void ListView::draw(Ui &context, Renderer &renderer, int x, int y, double angle)
+{
+    updateRows(context);
+
+    // Clip rows to the view, within any clip rect already set
+    SDL_Rect   clip {x, y, width, height};
+    SDL_Rect   previousClip {0, 0, 0, 0};
+    const auto wasClipped = SDL_RenderIsClipEnabled(renderer) == SDL_TRUE;
+    if (wasClipped) {
+        SDL_RenderGetClipRect(renderer, &previousClip);
+        SDL_IntersectRect(&clip, &previousClip, &clip);
+    }
+    SDL_RenderSetClipRect(renderer, &clip);
+
+    for (auto &row : rows)
+        row.widget->draw(context, renderer, x, y + getItemTop(row.index) - scroll, angle);
+
+    SDL_RenderSetClipRect(renderer, wasClipped ? &previousClip : nullptr);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UiHitIndex::build(UiDrawable &root)
+{
+    previous.swap(elements);
+    elements.clear();
+    collect(root, 0, 0);
+
+    // Most layout changes, like new label text, move nothing
+    auto same = [](const Element &a, const Element &b) {
+        return a.drawable == b.drawable && a.rect.x == b.rect.x && a.rect.y == b.rect.y &&
+               a.rect.w == b.rect.w && a.rect.h == b.rect.h;
+    };
+    if (std::equal(elements.begin(), elements.end(), previous.begin(), previous.end(), same))
+        return;
+
+    bandTops.clear();
+    bandSpans.clear();
+    spans.clear();
+    for (const auto &e : elements) {
+        bandTops.push_back(e.rect.y);
+        bandTops.push_back(e.rect.y + e.rect.h);
+    }
+    std::sort(bandTops.begin(), bandTops.end());
+    bandTops.erase(std::unique(bandTops.begin(), bandTops.end()), bandTops.end());
+
+    byTop.resize(elements.size());
+    std::iota(byTop.begin(), byTop.end(), std::size_t {0});
+    std::sort(byTop.begin(), byTop.end(),
+              [&](auto a, auto b) { return elements[a].rect.y < elements[b].rect.y; });
+
+    // Sweep down the bands, keeping the elements spanning the current one in drawing order
+    active.clear();
+    auto next = byTop.begin();
+    for (std::size_t b = 0; b + 1 < bandTops.size(); b++) {
+        const auto top = bandTops[b];
+        std::erase_if(active, [&](auto i) {
+            return elements[i].rect.y + elements[i].rect.h <= top;
+        });
+        for (; next != byTop.end() && elements[*next].rect.y <= top; ++next)
+            active.insert(std::upper_bound(active.begin(), active.end(), *next), *next);
+
+        band.clear();
+        for (const auto i : active)
+            paint(elements[i]);
+        bandSpans.push_back(spans.size());
+        spans.insert(spans.end(), band.begin(), band.end());
+    }
+    bandSpans.push_back(spans.size());
+}
+
+void UiHitIndex::clear() noexcept
+{
+    bandTops.clear();
+    bandSpans.clear();
+    spans.clear();
+    elements.clear();
+}
+
+UiDrawable *UiHitIndex::at(int x, int y) const noexcept
+{
+    if (bandTops.size() < 2 || y < bandTops.front() || y >= bandTops.back()) return nullptr;
+
+    const auto b = static_cast<std::size_t>(
+        std::upper_bound(bandTops.begin(), bandTops.end(), y) - bandTops.begin() - 1);
+    const auto first = spans.begin() + static_cast<std::ptrdiff_t>(bandSpans[b]);
+    const auto last = spans.begin() + static_cast<std::ptrdiff_t>(bandSpans[b + 1]);
+
+    auto it = std::upper_bound(first, last, x, [](int v, const Span &s) { return v < s.x0; });
+    if (it == first) return nullptr;
+    --it;
+    return x < it->x1 ? it->drawable : nullptr;
+}
+
+void UiHitIndex::collect(UiDrawable &drawable, int x, int y)
+{
+    if (drawable.width > 0 && drawable.height > 0)
+        elements.push_back({{x, y, drawable.width, drawable.height}, &drawable});
+
+    for (auto *child : drawable.getChildren())
+        collect(*child, x + child->offsetX, y + child->offsetY);
+}
+
+void UiHitIndex::paint(const Element &element)
+{
+    // Cover the spans of the band under the element, splitting those it overlaps partly
+    const Span span {element.rect.x, element.rect.x + element.rect.w, element.drawable};
+    bool       inserted = false;
+
+    scratch.clear();
+    for (const auto &s : band) {
+        if (s.x1 <= span.x0) {
+            scratch.push_back(s);
+            continue;
+        }
+        if (s.x0 < span.x0) scratch.push_back({s.x0, span.x0, s.drawable});
+        if (!inserted) {
+            scratch.push_back(span);
+            inserted = true;
+        }
+        if (s.x1 > span.x1) scratch.push_back({std::max(s.x0, span.x1), s.x1, s.drawable});
+    }
+    if (!inserted) scratch.push_back(span);
+    band.swap(scratch);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -107,11 +496,170 @@ Ui::Ui(std::shared_ptr<Font> defaultFont_)
 
 void Ui::measure()
 {
-    root->measure(*this);
+    updateLayout();
+}
+
+void Ui::updateLayout()
+{
+    if (root == nullptr) return;
+
+    if (root->isLayoutDirty()) {
+        root->updateLayout(*this);
+        hitIndexDirty = true;
+    }
+    if (!hitIndexDirty) return;
+
+    hitIndexDirty = false;
+    hitIndex.build(*root);
+    if (hasMouse) setHovered(hitIndex.at(mouseX - originX, mouseY - originY));
 }
 
 void Ui::draw(Renderer &renderer, int x, int y, double angle)
 {
     if (root == nullptr) return;
-    root->draw(*this, renderer, x, y, angle);
+    updateLayout();
+
+    if (x != originX || y != originY) {
+        originX = x;
+        originY = y;
+        if (hasMouse) setHovered(hitIndex.at(mouseX - originX, mouseY - originY));
+    }
+
+    if (composited)
+        drawComposited(renderer, x, y, angle);
+    else
+        root->draw(*this, renderer, x, y, angle);
+}
+
+void Ui::setComposited(bool enable)
+{
+    composited = enable;
+    target = Texture {};
+}
+
+void Ui::drawComposited(Renderer &renderer, int x, int y, double angle)
+{
+    if (root->width <= 0 || root->height <= 0) return;
+
+    if (target.getWidth() != root->width || target.getHeight() != root->height) {
+        auto *texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                          SDL_TEXTUREACCESS_TARGET, root->width, root->height);
+        if (texture == nullptr) throw SDLError("Create UI target texture");
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        target = Texture {texture, root->width, root->height};
+        root->requestRedraw();
+    }
+
+    redraws.clear();
+    root->collectRedraws(0, 0, redraws);
+
+    if (!redraws.empty()) {
+        auto         *previousTarget = SDL_GetRenderTarget(renderer);
+        SDL_BlendMode previousBlendMode;
+        SDL_GetRenderDrawBlendMode(renderer, &previousBlendMode);
+        SDL_SetRenderTarget(renderer, target.get());
+
+        for (const auto &r : redraws) {
+            // Clear to transparent, then draw the element over it
+            SDL_Rect area {r.x, r.y, r.drawable->width, r.drawable->height};
+            SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+            SDL_RenderFillRect(renderer, &area);
+            renderer.countDrawCalls();
+            SDL_SetRenderDrawBlendMode(renderer, previousBlendMode);
+
+            SDL_RenderSetClipRect(renderer, &area);
+            r.drawable->draw(*this, renderer, r.x, r.y, angle);
+            SDL_RenderSetClipRect(renderer, nullptr);
+        }
+
+        SDL_SetRenderTarget(renderer, previousTarget);
+    }
+
+    SDL_Rect dest {x, y, target.getWidth(), target.getHeight()};
+    target.renderTo(renderer, nullptr, &dest);
+}
+
+bool Ui::handleMouseMotion(const SDL_MouseMotionEvent &event)
+{
+    mouseX = event.x;
+    mouseY = event.y;
+    hasMouse = true;
+    updateLayout();
+    if (root == nullptr) return false;
+
+    auto *hit = hitIndex.at(mouseX - originX, mouseY - originY);
+    setHovered(hit);
+    return hit != nullptr;
+}
+
+bool Ui::handleMouseButton(const SDL_MouseButtonEvent &event)
+{
+    mouseX = event.x;
+    mouseY = event.y;
+    hasMouse = true;
+    updateLayout();
+    if (root == nullptr) return false;
+
+    const auto x = mouseX - originX;
+    const auto y = mouseY - originY;
+
+    if (event.type == SDL_MOUSEBUTTONUP && captured != nullptr) {
+        auto      *receiver = captured;
+        const auto p = positionOf(receiver);
+        captured = nullptr;
+        receiver->onMouseButton(event, x - p.x, y - p.y);
+        return true;
+    }
+
+    auto *hit = hitIndex.at(x, y);
+    if (hit == nullptr) return false;
+
+    auto p = positionOf(hit);
+    for (auto *d = hit; d != nullptr; d = d->getParent()) {
+        if (d->onMouseButton(event, x - p.x, y - p.y)) {
+            if (event.type == SDL_MOUSEBUTTONDOWN) captured = d;
+            return true;
+        }
+        p.x -= d->offsetX;
+        p.y -= d->offsetY;
+    }
+    return true;
+}
+
+bool Ui::handleMouseWheel(const SDL_MouseWheelEvent &event)
+{
+    updateLayout();
+    if (root == nullptr || !hasMouse) return false;
+
+    auto *hit = hitIndex.at(mouseX - originX, mouseY - originY);
+    for (auto *d = hit; d != nullptr; d = d->getParent())
+        if (d->onMouseWheel(event)) return true;
+    return hit != nullptr;
+}
+
+void Ui::handleMouseLeave()
+{
+    hasMouse = false;
+    setHovered(nullptr);
+}
+
+void Ui::setHovered(UiDrawable *drawable)
+{
+    if (drawable == hovered) return;
+
+    for (auto *d = hovered; d != nullptr && !isWithin(drawable, d); d = d->getParent())
+        d->onMouseLeave();
+    enter(drawable, hovered);
+    hovered = drawable;
+}
+
+Point2i Ui::positionOf(const UiDrawable *drawable) const noexcept
+{
+    Point2i p {0, 0};
+    for (; drawable != nullptr && drawable != root.get(); drawable = drawable->getParent()) {
+        p.x += drawable->offsetX;
+        p.y += drawable->offsetY;
+    }
+    return p;
 }
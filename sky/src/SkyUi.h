@@ -15,16 +15,97 @@ namespace sky
 {
 
 class Ui;
+class UiDrawable;
 
+/// @brief An element to redraw in a composited Ui, at its position within the Ui
+struct UiRedraw {
+    UiDrawable *drawable;
+    int         x;
+    int         y;
+};
+
+/**
+ * @brief Base of all UI elements, in a retained tree
+ *
+ * Sizes and child positions are cached. After a change that can affect the size of an
+ * element, call requestLayout(). The next updateLayout() of the tree, done by Ui before
+ * drawing, re-measures only marked elements, and their ancestors only if a size changed.
+ */
 class UiDrawable
 {
 public:
     virtual ~UiDrawable() = default;
     virtual void draw(Ui &context, Renderer &renderer, int x, int y, double angle) = 0;
+
+    /// @brief Compute width and height; containers use the current sizes of their children
     virtual void measure(const Ui &context) = 0;
 
+    /// @brief Position children by setting their offsets; called after measure()
+    virtual void layout() {}
+
+    /// @brief Mark for measure and layout in the next updateLayout(); implies requestRedraw()
+    void requestLayout() noexcept;
+
+    /// @brief Mark as changed, for a composited Ui to redraw the area of this element
+    void requestRedraw() noexcept;
+
+    /**
+     * @brief Collect and unmark the topmost elements marked for redraw
+     *
+     * @arg x, y position of this element within the Ui
+     */
+    void collectRedraws(int x, int y, std::vector<UiRedraw> &out);
+
+    /**
+     * @brief Measure and lay out marked elements of this subtree
+     *
+     * @return true if the size of this element changed
+     */
+    bool updateLayout(const Ui &context);
+
+    [[nodiscard]] bool isLayoutDirty() const noexcept { return needsMeasure || hasDirtyChildren; }
+
+    /// @brief The pointer entered or left the area of this element, including its children
+    virtual void onMouseEnter() {}
+    virtual void onMouseLeave() {}
+
+    /**
+     * @brief A mouse button was pressed or released over this element
+     *
+     * A release goes to the element that handled the press, even if the pointer moved away.
+     *
+     * @arg x, y pointer position relative to this element
+     * @return true if handled, otherwise the event goes to the parent
+     */
+    virtual bool onMouseButton(const SDL_MouseButtonEvent &, int, int) { return false; }
+
+    /// @return true if handled, otherwise the event goes to the parent
+    virtual bool onMouseWheel(const SDL_MouseWheelEvent &) { return false; }
+
+    [[nodiscard]] UiDrawable *getParent() const noexcept { return parent; }
+    [[nodiscard]] const std::vector<UiDrawable *> &getChildren() const noexcept
+    {
+        return children;
+    }
+
     int width {0};
     int height {0};
+    int offsetX {0}; ///< position relative to the parent, set by the parent layout()
+    int offsetY {0};
+
+protected:
+    std::vector<UiDrawable *> children;
+
+    void addChild(UiDrawable *child);
+
+private:
+    UiDrawable *parent {nullptr};
+    bool        needsMeasure {true};
+    bool        hasDirtyChildren {false};
+    bool        needsRedraw {true};
+    bool        hasRedrawChildren {false};
+
+    void clearRedraws() noexcept;
 };
 
 /* -------------------------------------------------------------------------- */
@@ -34,25 +115,50 @@ class Widget : public UiDrawable
 public:
     void draw(Ui &context, Renderer &renderer, int x, int y, double angle) override;
 
-    void               setFont(const std::shared_ptr<Font> font_) noexcept { font = font_; }
+    void setFont(const std::shared_ptr<Font> font_) noexcept
+    {
+        font = font_;
+        requestLayout();
+    }
     [[nodiscard]] auto getFont() const noexcept -> std::shared_ptr<Font> { return font; }
 
-    void               setForegroundColor(Color color) noexcept { foregroundColor = color; }
+    void setForegroundColor(Color color) noexcept
+    {
+        foregroundColor = color;
+        requestRedraw();
+    }
     [[nodiscard]] auto getForegroundColor() const noexcept -> Color { return foregroundColor; }
 
-    void               setBackgroundColor(Color color) noexcept { backgroundColor = color; }
+    void setBackgroundColor(Color color) noexcept
+    {
+        backgroundColor = color;
+        requestRedraw();
+    }
     [[nodiscard]] auto getBackgroundColor() const noexcept -> Color { return backgroundColor; }
 
-    void invalidate() { valid = false; }
+    void invalidate()
+    {
+        valid = false;
+        requestRedraw();
+    }
 
 protected:
     std::shared_ptr<Font> font;
     Color                 foregroundColor {255, 255, 255, 255};
     Color                 backgroundColor {0, 0, 0, 255};
 
-    Texture texture;
+    std::shared_ptr<const Texture> texture;
+
+    /// @brief Draw the widget contents over the background; by default the render() texture
+    virtual void drawContent(Ui &context, Renderer &renderer, int x, int y);
 
-    virtual Texture render(Ui &context) = 0;
+    /**
+     * @brief Render the contents to a texture, called again after invalidate()
+     *
+     * Widgets showing text should use Font::renderCached(), to share textures of equal text,
+     * or skip the texture and draw in drawContent() with Font::drawText().
+     */
+    virtual std::shared_ptr<const Texture> render(Ui &) { return nullptr; }
 
 private:
     bool valid {false};
@@ -78,22 +184,26 @@ public:
     template <class S> Label(const S &spec)
     {
         if constexpr (requires { spec.text; }) text = spec.text;
-        if constexpr (requires { spec.width; }) width = spec.width;
-        if constexpr (requires { spec.height; }) height = spec.height;
+        if constexpr (requires { spec.width; }) width = fixedWidth = spec.width;
+        if constexpr (requires { spec.height; }) height = fixedHeight = spec.height;
     }
 
     void measure(const Ui &context) override;
 
-    void setText(const std::string &text_) noexcept
+    /// @brief Cheap enough to call every frame: text is drawn from the font glyph atlas
+    void setText(const std::string &text_)
     {
+        if (text == text_) return;
         text = text_;
-        invalidate();
+        requestLayout();
     }
 
 private:
     std::string text;
+    int         fixedWidth {0};  ///< 0 - fit the text
+    int         fixedHeight {0}; ///< 0 - fit the text
 
-    Texture render(Ui &context) override;
+    void drawContent(Ui &context, Renderer &renderer, int x, int y) override;
 };
 
 /* -------------------------------------------------------------------------- */
@@ -107,10 +217,137 @@ public:
     LinearLayout &operator+=(UiDrawable *d);
     void          draw(Ui &context, Renderer &renderer, int x, int y, double angle) override;
     void          measure(const Ui &context) override;
+    void          layout() override;
+
+private:
+    bool vertical {true};
+};
+
+/* -------------------------------------------------------------------------- */
+
+/// @brief Data source of a ListView
+class ListAdapter
+{
+public:
+    virtual ~ListAdapter() = default;
+
+    [[nodiscard]] virtual int getCount() const = 0;
+
+    /// @brief Create an unbound row widget; rows are recycled for other items when scrolling
+    virtual std::unique_ptr<UiDrawable> createRow() = 0;
+
+    /// @brief Show item index in a row, e.g. by setting the text of a Label
+    virtual void bindRow(UiDrawable &row, int index) = 0;
+
+    /// @brief Height of an item, only used by ListViews without a fixed row height
+    [[nodiscard]] virtual int getRowHeight(int) const { return 0; }
+};
+
+/**
+ * @brief A scrollable list that only creates and draws the visible rows
+ *
+ * Rows scrolled out of view are recycled and bound to the items scrolling into view, so the
+ * number of row widgets depends on the view height, not on the number of items. With a fixed
+ * row height, finding the visible items is O(1); otherwise row heights are queried once
+ * from the adapter and cached as offsets, searched in O(log n).
+ *
+ * Call notifyDataChanged() after the items change, or notifyItemChanged() if only one did.
+ */
+class ListView : public UiDrawable
+{
+public:
+    /// @arg rowHeight fixed height of all rows; 0 - use ListAdapter::getRowHeight()
+    ListView(int width, int height, std::shared_ptr<ListAdapter> adapter, int rowHeight = 0);
+
+    void draw(Ui &context, Renderer &renderer, int x, int y, double angle) override;
+    void measure(const Ui &context) override;
+
+    /// @brief Forwarded to the row under the pointer
+    bool onMouseButton(const SDL_MouseButtonEvent &event, int x, int y) override;
+
+    /// @brief Scrolls the list; not handled at either end, so an outer list can scroll
+    bool onMouseWheel(const SDL_MouseWheelEvent &event) override;
+
+    void notifyDataChanged();
+    void notifyItemChanged(int index);
+
+    /// @arg offset in pixels from the top of the first item, clamped to the content
+    void scrollTo(int offset);
+    void scrollBy(int pixels) { scrollTo(scroll + pixels); }
+    void scrollToItem(int index);
+
+    [[nodiscard]] int getScroll() const noexcept { return scroll; }
+    [[nodiscard]] int getContentHeight() const noexcept;
+
+    /// @brief Item at a vertical position in the content, -1 if none
+    [[nodiscard]] int itemAt(int contentY) const noexcept;
+    [[nodiscard]] int getItemTop(int index) const noexcept;
 
 private:
-    bool                      vertical {true};
-    std::vector<UiDrawable *> contents;
+    struct Row {
+        int                         index;
+        std::unique_ptr<UiDrawable> widget;
+    };
+
+    std::shared_ptr<ListAdapter> adapter;
+    const int                    fixedRowHeight;
+    int                          count {0};
+    int                          scroll {0};
+    std::vector<int>             rowOffsets; ///< count + 1 item tops, without fixed height
+
+    std::vector<Row>                         rows; ///< visible rows, ordered by item
+    std::vector<Row>                         nextRows;
+    std::vector<std::unique_ptr<UiDrawable>> recycled;
+    std::vector<int>                         changedItems;
+
+    void updateRows(const Ui &context);
+    void bind(const Ui &context, Row &row);
+};
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Flat index of the areas of a UiDrawable tree, for hit-testing in O(log n)
+ *
+ * The edges of all areas split the tree into horizontal bands. Each band holds sorted,
+ * non-overlapping spans of the element seen from above: the deepest one, and the last drawn
+ * among overlapping siblings. A lookup is a binary search for the band, then for the span.
+ */
+class UiHitIndex
+{
+public:
+    /// @brief Index the tree at its cached sizes and offsets; cheap if none of them changed
+    void build(UiDrawable &root);
+    void clear() noexcept;
+
+    /// @brief Element at a point relative to the root, nullptr if none
+    [[nodiscard]] UiDrawable *at(int x, int y) const noexcept;
+
+private:
+    struct Element {
+        SDL_Rect    rect;
+        UiDrawable *drawable;
+    };
+
+    struct Span {
+        int         x0;
+        int         x1;
+        UiDrawable *drawable;
+    };
+
+    std::vector<int>         bandTops;  ///< ascending, ending with the bottom of the last band
+    std::vector<std::size_t> bandSpans; ///< first span of each band, ending with spans.size()
+    std::vector<Span>        spans;
+
+    std::vector<Element>     elements; ///< in drawing order, as of the last build
+    std::vector<Element>     previous;
+    std::vector<std::size_t> byTop;
+    std::vector<std::size_t> active;
+    std::vector<Span>        band;
+    std::vector<Span>        scratch;
+
+    void collect(UiDrawable &drawable, int x, int y);
+    void paint(const Element &element);
 };
 
 /* -------------------------------------------------------------------------- */
@@ -120,15 +357,75 @@ class Ui : public Drawable
 public:
     Ui(std::shared_ptr<Font> defaultFont);
     void draw(Renderer &renderer, int x, int y, double angle) override;
+
+    /// @brief Bring sizes and positions up to date; draw() does this automatically
     void measure();
 
     [[nodiscard]] auto getDefaultFont() const noexcept { return defaultFont; }
 
-    void setRoot(std::shared_ptr<UiDrawable> root_) noexcept { root = root_; }
+    void setRoot(std::shared_ptr<UiDrawable> root_) noexcept
+    {
+        root = root_;
+        if (root) root->requestLayout();
+        hovered = nullptr;
+        captured = nullptr;
+        hitIndexDirty = true;
+    }
+
+    /**
+     * @brief Mouse input, in screen coordinates
+     *
+     * Elements are found in a UiHitIndex of the positions from the last layout, relative to
+     * where the Ui was last drawn. Button and wheel events go to the element under the
+     * pointer, then to its ancestors until one handles them.
+     *
+     * @return true if the pointer is over an element, or the event was handled
+     */
+    bool handleMouseMotion(const SDL_MouseMotionEvent &event);
+    bool handleMouseButton(const SDL_MouseButtonEvent &event);
+    bool handleMouseWheel(const SDL_MouseWheelEvent &event);
+
+    /// @brief The pointer left the Ui, e.g. covered by another one
+    void handleMouseLeave();
+
+    [[nodiscard]] UiDrawable *getHovered() const noexcept { return hovered; }
+
+    /// @brief An element handled a button press, and gets the release wherever it happens
+    [[nodiscard]] bool isCapturing() const noexcept { return captured != nullptr; }
+
+    /**
+     * @brief Render the tree into an offscreen texture, redrawing only changed elements
+     *
+     * Each frame, elements marked with requestRedraw() or changed by layout are cleared and
+     * redrawn into the texture, which is then copied to the screen. When nothing changed,
+     * drawing the Ui is a single texture copy. The renderer must support render targets.
+     */
+    void setComposited(bool enable);
+
+    [[nodiscard]] bool isComposited() const noexcept { return composited; }
 
 private:
     std::shared_ptr<Font>       defaultFont;
     std::shared_ptr<UiDrawable> root;
+
+    bool                  composited {false};
+    Texture               target;
+    std::vector<UiRedraw> redraws;
+
+    UiHitIndex  hitIndex;
+    bool        hitIndexDirty {true};
+    UiDrawable *hovered {nullptr};
+    UiDrawable *captured {nullptr};
+    int         originX {0}; ///< screen position of the last draw
+    int         originY {0};
+    int         mouseX {0}; ///< last pointer position, in screen coordinates
+    int         mouseY {0};
+    bool        hasMouse {false};
+
+    void updateLayout();
+    void drawComposited(Renderer &renderer, int x, int y, double angle);
+    void setHovered(UiDrawable *drawable);
+    mist::Point2i positionOf(const UiDrawable *drawable) const noexcept;
 };
 
 } // namespace sky
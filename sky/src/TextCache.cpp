@@ -0,0 +1,105 @@
+#include "TextCache.h"
+
+#include <functional>
+
+using namespace sky;
+
+namespace
+{
+
+Uint32 packColor(const Color &c)
+{
+    return static_cast<Uint32>(c.r) << 24u | static_cast<Uint32>(c.g) << 16u |
+           static_cast<Uint32>(c.b) << 8u | static_cast<Uint32>(c.a);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+std::size_t TextCache::KeyHash::operator()(const KeyView &k) const noexcept
+{
+    auto h = std::hash<std::string_view> {}(k.text);
+    for (const std::uint64_t v : {k.fontId, static_cast<std::uint64_t>(k.style),
+                                  static_cast<std::uint64_t>(k.color)}) {
+        h ^= std::hash<std::uint64_t> {}(v) + 0x9e3779b97f4a7c15u + (h << 6u) + (h >> 2u);
+    }
+    return h;
+}
+
+bool TextCache::KeyEqual::operator()(const KeyView &a, const KeyView &b) const noexcept
+{
+    return a.fontId == b.fontId && a.style == b.style && a.color == b.color && a.text == b.text;
+}
+
+/* -------------------------------------------------------------------------- */
+
+TextCache::TextCache(std::size_t budgetBytes) : budget(budgetBytes)
+{
+}
+
+TextCache &TextCache::shared()
+{
+    static TextCache instance;
+    return instance;
+}
+
+TextCache::SharedTexture TextCache::get(const Font &font, std::string_view text,
+                                        const Color &color)
+{
+    const KeyView key {font.getId(), font.getStyle(), packColor(color), text};
+
+    if (auto it = index.find(key); it != index.end()) {
+        stats.hits++;
+        lru.splice(lru.begin(), lru, it->second);
+        return it->second->texture;
+    }
+
+    stats.misses++;
+    const std::string string {text};
+    auto texture = std::make_shared<const Texture>(font.renderSolid(string, color));
+    const auto bytes = static_cast<std::size_t>(texture->getWidth()) *
+                       static_cast<std::size_t>(texture->getHeight()) * 4;
+
+    lru.push_front({Key {key.fontId, key.style, key.color, string}, texture, bytes});
+    index.emplace(lru.front().key, lru.begin());
+    stats.bytes += bytes;
+    stats.entries++;
+
+    evict();
+    return texture;
+}
+
+void TextCache::setBudget(std::size_t bytes)
+{
+    budget = bytes;
+    evict();
+}
+
+void TextCache::clear()
+{
+    index.clear();
+    lru.clear();
+    stats.bytes = 0;
+    stats.entries = 0;
+}
+
+void TextCache::resetStats() noexcept
+{
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.evictions = 0;
+}
+
+void TextCache::evict()
+{
+    // The newest entry always stays, even if it alone is over budget
+    while (stats.bytes > budget && lru.size() > 1) {
+        const auto &oldest = lru.back();
+        stats.bytes -= oldest.bytes;
+        stats.entries--;
+        stats.evictions++;
+        index.erase(oldest.key);
+        lru.pop_back();
+    }
+}
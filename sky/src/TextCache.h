@@ -0,0 +1,100 @@
+#ifndef SKY_TEXTCACHE_H_
+#define SKY_TEXTCACHE_H_
+
+#include "Color.h"
+#include "Sky.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace sky
+{
+
+struct TextCacheStats {
+    std::uint64_t hits {0};
+    std::uint64_t misses {0};
+    std::uint64_t evictions {0};
+    std::size_t   bytes {0};
+    std::size_t   entries {0};
+};
+
+/**
+ * @brief LRU cache of rendered text textures
+ *
+ * Textures are keyed by font, font style, color and string, so identical captions and
+ * repeating readouts are rasterized once and shared. The total size of cached textures,
+ * counted as 4 bytes per pixel, is kept within a budget by evicting the least recently used
+ * entries. Evicted textures stay valid for as long as someone holds them.
+ *
+ * Not thread-safe; use from the rendering thread only.
+ */
+class TextCache
+{
+public:
+    using SharedTexture = std::shared_ptr<const Texture>;
+
+    explicit TextCache(std::size_t budgetBytes = 8 * 1024 * 1024);
+
+    /// @brief The cache used by Font::renderCached()
+    static TextCache &shared();
+
+    SharedTexture get(const Font &font, std::string_view text, const Color &color);
+
+    void setBudget(std::size_t bytes);
+    void clear();
+
+    [[nodiscard]] const TextCacheStats &getStats() const noexcept { return stats; }
+    void resetStats() noexcept;
+
+private:
+    struct KeyView {
+        std::uint64_t    fontId;
+        int              style;
+        Uint32           color;
+        std::string_view text;
+    };
+
+    struct Key {
+        std::uint64_t fontId;
+        int           style;
+        Uint32        color;
+        std::string   text;
+
+        operator KeyView() const noexcept { return {fontId, style, color, text}; }
+    };
+
+    struct KeyHash {
+        using is_transparent = void;
+        std::size_t operator()(const KeyView &k) const noexcept;
+        std::size_t operator()(const Key &k) const noexcept { return (*this)(KeyView(k)); }
+    };
+
+    struct KeyEqual {
+        using is_transparent = void;
+        bool operator()(const KeyView &a, const KeyView &b) const noexcept;
+    };
+
+    struct Entry {
+        Key           key;
+        SharedTexture texture;
+        std::size_t   bytes;
+    };
+
+    using Lru = std::list<Entry>;
+
+    std::size_t                                               budget;
+    Lru                                                       lru; ///< most recent first
+    std::unordered_map<Key, Lru::iterator, KeyHash, KeyEqual> index;
+    TextCacheStats                                            stats;
+
+    void evict();
+};
+
+} // namespace sky
+
+#endif
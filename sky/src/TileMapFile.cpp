@@ -0,0 +1,155 @@
+#include "TileMapFile.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace sky;
+
+namespace
+{
+
+std::runtime_error fileError(const char *what, const char *file)
+{
+    return std::runtime_error(std::string(what) + ": " + file);
+}
+
+void checkHeader(const TileMapFileHeader &header, const char *file)
+{
+    if (header.magic != TileMapFileHeader::Magic) throw fileError("Not a tile map file", file);
+    if (header.byteOrder != TileMapFileHeader::ByteOrderMark) {
+        throw fileError("Tile map file has foreign byte order", file);
+    }
+    if (header.version > TileMapFileHeader::CurrentVersion) {
+        throw fileError("Unsupported tile map file version", file);
+    }
+    if (header.cellSize != 1 && header.cellSize != 2 && header.cellSize != 4) {
+        throw fileError("Invalid tile map cell size", file);
+    }
+    if (header.dataOffset < sizeof(TileMapFileHeader) || header.dataOffset % header.cellSize) {
+        throw fileError("Invalid tile map data offset", file);
+    }
+
+    const auto expectedSize = static_cast<std::uint64_t>(header.width) * header.height *
+                              header.numLayers * header.cellSize;
+    if (header.dataSize != expectedSize) throw fileError("Invalid tile map data size", file);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const char *file)
+{
+    HANDLE handle = CreateFileA(file, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) throw fileError("Open file", file);
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(handle);
+        throw fileError("Empty or unreadable file", file);
+    }
+    length = static_cast<std::size_t>(fileSize.QuadPart);
+
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (mapping == nullptr) throw fileError("Map file", file);
+
+    address = static_cast<std::byte *>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+    if (address == nullptr) {
+        CloseHandle(mapping);
+        throw fileError("Map file", file);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    UnmapViewOfFile(address);
+    CloseHandle(mapping);
+}
+
+#else
+
+MappedFile::MappedFile(const char *file)
+{
+    const int fd = open(file, O_RDONLY);
+    if (fd < 0) throw fileError("Open file", file);
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw fileError("Empty or unreadable file", file);
+    }
+    length = static_cast<std::size_t>(st.st_size);
+
+    // Private writable mapping: cells can be edited in memory, the file is never modified
+    void *ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) throw fileError("Map file", file);
+
+    address = static_cast<std::byte *>(ptr);
+}
+
+MappedFile::~MappedFile()
+{
+    munmap(address, length);
+}
+
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+TileMapFileHeader TileMapFile::readHeader(const char *file)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in) throw fileError("Open tile map file", file);
+
+    TileMapFileHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in) throw fileError("Truncated tile map file", file);
+
+    checkHeader(header, file);
+    return header;
+}
+
+TileMapFileHeader TileMapFile::validate(const MappedFile &mapped, const char *file)
+{
+    TileMapFileHeader header;
+    if (mapped.size() < sizeof(header)) throw fileError("Truncated tile map file", file);
+    std::memcpy(&header, mapped.data(), sizeof(header));
+
+    checkHeader(header, file);
+    if (header.dataOffset + header.dataSize > mapped.size()) {
+        throw fileError("Truncated tile map file", file);
+    }
+    return header;
+}
+
+void TileMapFile::write(const char *file, const TileMapFileHeader &header,
+                        std::span<const std::byte> data)
+{
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    if (!out) throw fileError("Create tile map file", file);
+
+    std::array<char, TileMapFileHeader::DataOffset> headerBlock {};
+    std::memcpy(headerBlock.data(), &header, sizeof(header));
+    out.write(headerBlock.data(), headerBlock.size());
+    out.write(reinterpret_cast<const char *>(data.data()),
+              static_cast<std::streamsize>(data.size()));
+
+    if (!out) throw fileError("Write tile map file", file);
+}
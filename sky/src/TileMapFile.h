@@ -0,0 +1,108 @@
+#ifndef SKY_TILEMAPFILE_H_
+#define SKY_TILEMAPFILE_H_
+
+#include "Tiles.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace sky
+{
+
+/// @brief Header of a binary tile map file, followed by the cells of all layers
+struct TileMapFileHeader {
+    static constexpr std::uint32_t Magic = 0x4d594b53; // "SKYM"
+    static constexpr std::uint16_t CurrentVersion = 1;
+    static constexpr std::uint16_t ByteOrderMark = 0x0102;
+    static constexpr std::uint32_t DataOffset = 64;
+
+    std::uint32_t magic {Magic};
+    std::uint16_t version {CurrentVersion};
+    std::uint16_t byteOrder {ByteOrderMark};
+    std::uint32_t cellSize {0};
+    std::uint32_t width {0};
+    std::uint32_t height {0};
+    std::uint32_t numLayers {0};
+    std::uint32_t dataOffset {DataOffset};
+    std::uint32_t reserved {0};
+    std::uint64_t dataSize {0};
+};
+
+/// @brief A read-only file mapped into memory with copy-on-write pages
+class MappedFile
+{
+public:
+    explicit MappedFile(const char *file);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(MappedFile &&) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile &operator=(MappedFile &&) = delete;
+
+    [[nodiscard]] std::byte  *data() const noexcept { return address; }
+    [[nodiscard]] std::size_t size() const noexcept { return length; }
+
+private:
+    std::byte  *address {nullptr};
+    std::size_t length {0};
+#ifdef _WIN32
+    void *mapping {nullptr};
+#endif
+};
+
+/**
+ * @brief Versioned binary format for TileMaps
+ *
+ * The file holds a fixed-size header and the raw cells of all layers, in the same layout as
+ * BasicTileMap storage, in native byte order. load() maps the file into memory and uses the
+ * mapped pages as map storage directly, without copying; pages are read in lazily by the OS
+ * on first access. The mapping is private: edits to a loaded map are never written back to
+ * the file, use save() for that.
+ */
+struct TileMapFile {
+    static TileMapFileHeader readHeader(const char *file);
+
+    template <class Cell> static void save(const BasicTileMap<Cell> &map, const char *file)
+    {
+        TileMapFileHeader header;
+        header.cellSize = sizeof(Cell);
+        header.width = static_cast<std::uint32_t>(map.getWidth());
+        header.height = static_cast<std::uint32_t>(map.getHeight());
+        header.numLayers = static_cast<std::uint32_t>(map.getNumLayers());
+        header.dataSize = map.getCells().size_bytes();
+
+        write(file, header, std::as_bytes(map.getCells()));
+    }
+
+    template <class Cell>
+    static std::shared_ptr<BasicTileMap<Cell>> load(const char *file, SharedTileset tileset)
+    {
+        auto mapped = std::make_shared<MappedFile>(file);
+        auto header = validate(*mapped, file);
+        if (header.cellSize != sizeof(Cell)) {
+            throw std::runtime_error(std::string("Load tile map: cell size mismatch in ") + file);
+        }
+
+        auto             *cells = reinterpret_cast<Cell *>(mapped->data() + header.dataOffset);
+        const std::size_t numCells = header.dataSize / sizeof(Cell);
+
+        return std::make_shared<BasicTileMap<Cell>>(
+            std::move(tileset), static_cast<int>(header.width), static_cast<int>(header.height),
+            static_cast<int>(header.numLayers), std::span<Cell> {cells, numCells},
+            std::move(mapped));
+    }
+
+private:
+    static void write(const char *file, const TileMapFileHeader &header,
+                      std::span<const std::byte> data);
+    static TileMapFileHeader validate(const MappedFile &mapped, const char *file);
+};
+
+} // namespace sky
+
+#endif
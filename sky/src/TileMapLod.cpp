@@ -0,0 +1,169 @@
+#include "TileMapLod.h"
+#include "Pixels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace sky;
+
+namespace
+{
+
+/// Alpha-weighted average, so transparent pixels do not darken their neighbors
+Color average(const Color &a, const Color &b, const Color &c, const Color &d)
+{
+    const int alpha = a.a + b.a + c.a + d.a;
+    if (alpha == 0) return {0, 0, 0, 0};
+
+    auto channel = [&](Uint8 Color::*m) {
+        return static_cast<Uint8>((a.*m * a.a + b.*m * b.a + c.*m * c.a + d.*m * d.a) / alpha);
+    };
+    return {channel(&Color::r), channel(&Color::g), channel(&Color::b),
+            static_cast<Uint8>(alpha / 4)};
+}
+
+/// Width of the map, after checking the layout the other members are computed from
+int checkedWidth(int width, int height, int chunkSize)
+{
+    if (width <= 0 || height <= 0) {
+        throw std::runtime_error("Tile map LOD: dimensions must be positive");
+    }
+    // Chunks hold chunkSize squared colors
+    if (chunkSize <= 0 || chunkSize > (1 << 15) || (chunkSize & (chunkSize - 1)) != 0) {
+        throw std::runtime_error("Tile map LOD: chunk size must be a power of 2");
+    }
+    return width;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+TileMapLod::TileMapLod(SharedDrawable detail_, int width_, int height_, ColorSource source_,
+                       int chunkSize_)
+    : detail(std::move(detail_)), width(checkedWidth(width_, height_, chunkSize_)),
+      height(height_), source(std::move(source_)), chunkSize(chunkSize_),
+      chunksX((width + chunkSize - 1) / chunkSize), chunksY((height + chunkSize - 1) / chunkSize),
+      chunks(static_cast<std::size_t>(chunksX) * static_cast<std::size_t>(chunksY))
+{
+    while ((1 << numLevels) <= chunkSize)
+        numLevels++;
+}
+
+int TileMapLod::getCurrentLevel() const noexcept
+{
+    if (detail && scale >= detailThreshold) return -1;
+    if (scale >= 1.0) return 0;
+
+    // Level l has one pixel per 2^l tiles, drawn scale * 2^l screen pixels wide
+    const auto level = static_cast<int>(std::ceil(std::log2(1.0 / scale)));
+    return std::min(level, numLevels - 1);
+}
+
+void TileMapLod::invalidate(const SDL_Rect &tiles)
+{
+    const auto cx0 = std::max(0, tiles.x / chunkSize);
+    const auto cy0 = std::max(0, tiles.y / chunkSize);
+    const auto cx1 = std::min(chunksX - 1, (tiles.x + tiles.w - 1) / chunkSize);
+    const auto cy1 = std::min(chunksY - 1, (tiles.y + tiles.h - 1) / chunkSize);
+
+    for (int cy = cy0; cy <= cy1; cy++)
+        for (int cx = cx0; cx <= cx1; cx++)
+            chunks[static_cast<std::size_t>(cy * chunksX + cx)].dirty = true;
+}
+
+void TileMapLod::invalidateAll()
+{
+    for (auto &chunk : chunks)
+        chunk.dirty = true;
+}
+
+void TileMapLod::rebuild(Chunk &chunk, int cx, int cy)
+{
+    chunk.colors.assign(static_cast<std::size_t>(chunkSize * chunkSize), Color {0, 0, 0, 0});
+
+    const auto x0 = cx * chunkSize;
+    const auto y0 = cy * chunkSize;
+    const auto x1 = std::min(width, x0 + chunkSize);
+    const auto y1 = std::min(height, y0 + chunkSize);
+    for (int y = y0; y < y1; y++)
+        for (int x = x0; x < x1; x++)
+            chunk.colors[static_cast<std::size_t>((y - y0) * chunkSize + x - x0)] =
+                source({x, y});
+
+    chunk.levels.clear();
+    chunk.levels.resize(static_cast<std::size_t>(numLevels));
+    chunk.dirty = false;
+}
+
+const Texture &TileMapLod::levelTexture(Chunk &chunk, int level)
+{
+    auto &texture = chunk.levels[static_cast<std::size_t>(level)];
+    if (texture.get() != nullptr) return texture;
+
+    // Halve the resolution level times; each pass writes behind the pixels it still reads
+    scratch.assign(chunk.colors.begin(), chunk.colors.end());
+    auto size = chunkSize;
+    for (int l = 0; l < level; l++) {
+        const auto half = size / 2;
+        for (int y = 0; y < half; y++) {
+            for (int x = 0; x < half; x++) {
+                const auto *top = scratch.data() + 2 * y * size + 2 * x;
+                const auto *bottom = top + size;
+                scratch[static_cast<std::size_t>(y * half + x)] =
+                    average(top[0], top[1], bottom[0], bottom[1]);
+            }
+        }
+        size = half;
+    }
+
+    Surface surface {size, size, 32};
+    SDL_LockSurface(surface.get());
+    const auto span = PixelSpan::of(surface.get(), {0, 0, size, size});
+    for (int y = 0; y < size; y++) {
+        Uint32 *row = span.row(y);
+        for (int x = 0; x < size; x++)
+            row[x] = span.pack(scratch[static_cast<std::size_t>(y * size + x)]);
+    }
+    SDL_UnlockSurface(surface.get());
+
+    texture = Texture {surface};
+    return texture;
+}
+
+void TileMapLod::draw(Renderer &renderer, int x, int y, double angle)
+{
+    const auto level = getCurrentLevel();
+    if (level < 0) {
+        detail->draw(renderer, x, y, angle);
+        return;
+    }
+
+    int screenWidth = 0;
+    int screenHeight = 0;
+    SDL_GetRendererOutputSize(renderer, &screenWidth, &screenHeight);
+
+    // Visible chunk range; x, y is the screen position of tile (0, 0)
+    const auto chunkPixels = scale * chunkSize;
+    const auto cx0 = std::max(0, static_cast<int>(std::floor(-x / chunkPixels)));
+    const auto cy0 = std::max(0, static_cast<int>(std::floor(-y / chunkPixels)));
+    const auto cx1 =
+        std::min(chunksX - 1, static_cast<int>(std::floor((screenWidth - x) / chunkPixels)));
+    const auto cy1 =
+        std::min(chunksY - 1, static_cast<int>(std::floor((screenHeight - y) / chunkPixels)));
+
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            auto &chunk = chunks[static_cast<std::size_t>(cy * chunksX + cx)];
+            if (chunk.dirty) rebuild(chunk, cx, cy);
+
+            // Edges from rounded positions, so neighboring chunks never leave a gap
+            const auto left = x + mist::roundi(cx * chunkPixels);
+            const auto top = y + mist::roundi(cy * chunkPixels);
+            SDL_Rect   dest {left, top, x + mist::roundi((cx + 1) * chunkPixels) - left,
+                           y + mist::roundi((cy + 1) * chunkPixels) - top};
+            levelTexture(chunk, level).renderTo(renderer, nullptr, &dest);
+        }
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef SKY_TILEMAPLOD_H_
+#define SKY_TILEMAPLOD_H_
+
+#include "Color.h"
+#include "SkyEngine.h"
+#include "Tiles.h"
+
+#include <mist/Point.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace sky
+{
+
+/**
+ * @brief Zoomed-out rendering of large tile maps
+ *
+ * Keeps mipmap-like levels of detail of a map: level 0 has one pixel per tile, in the average
+ * color of the tile, and every further level halves the resolution by averaging 2x2 blocks.
+ * The map is split into square chunks and every chunk is drawn as a single texture, so the
+ * number of draw calls depends only on the number of visible chunks.
+ *
+ * The level is chosen from the scale set with setScale(): the one whose pixels come closest
+ * to, but not below, one screen pixel. At scales of at least the detail threshold the detail
+ * Drawable (normally the TileMap itself) is drawn instead, tile by tile.
+ *
+ * Chunk textures are built on first use. After changing the map, call invalidate() with
+ * the changed area; affected chunks are rebuilt when they are next drawn.
+ */
+class TileMapLod : public Drawable
+{
+public:
+    /// @brief Color of a single tile at level 0
+    using ColorSource = std::function<Color(const mist::Point2i &tile)>;
+
+    /**
+     * @arg detail drawn instead of the LOD textures when zoomed in, may be null
+     * @arg chunkSize chunk width and height in tiles, a power of 2 up to 32768
+     */
+    TileMapLod(SharedDrawable detail, int width, int height, ColorSource source,
+               int chunkSize = 64);
+
+    /// @brief LOD for a TileMap, colored by the topmost visible non-empty layer
+    template <class Cell>
+    static std::shared_ptr<TileMapLod> forMap(std::shared_ptr<BasicTileMap<Cell>> map,
+                                              int chunkSize = 64)
+    {
+        auto source = [map = map.get()](const mist::Point2i &p) {
+            for (int layer = map->getNumLayers() - 1; layer >= 0; layer--) {
+                if (!map->isLayerVisible(layer)) continue;
+                const auto cell = map->at(layer, p);
+                if (cell != BasicTileMap<Cell>::Empty)
+                    return map->getTileset()->getTileColor(static_cast<int>(cell));
+            }
+            return Color {0, 0, 0, 0};
+        };
+        return std::make_shared<TileMapLod>(map, map->getWidth(), map->getHeight(),
+                                            std::move(source), chunkSize);
+    }
+
+    /// @brief Screen pixels per tile, i.e. the world-to-screen scale of a tile grid
+    void setScale(double pixelsPerTile) noexcept { scale = pixelsPerTile; }
+
+    [[nodiscard]] double getScale() const noexcept { return scale; }
+
+    /// @brief Minimum scale at which the detail Drawable is used, 8 pixels per tile by default
+    void setDetailThreshold(double pixelsPerTile) noexcept { detailThreshold = pixelsPerTile; }
+
+    [[nodiscard]] int getNumLevels() const noexcept { return numLevels; }
+
+    /// @brief Level used at the current scale; -1 for the detail Drawable
+    [[nodiscard]] int getCurrentLevel() const noexcept;
+
+    void invalidate(const SDL_Rect &tiles);
+    void invalidateAll();
+
+    void draw(Renderer &renderer, int x, int y, double angle) override;
+
+private:
+    struct Chunk {
+        std::vector<Color>   colors; ///< level 0, chunkSize squared
+        std::vector<Texture> levels; ///< built on demand, empty Texture if not built
+        bool                 dirty {true};
+    };
+
+    SharedDrawable     detail;
+    const int          width;
+    const int          height;
+    ColorSource        source;
+    const int          chunkSize;
+    const int          chunksX;
+    const int          chunksY;
+    int                numLevels {1};
+    double             scale {1.0};
+    double             detailThreshold {8.0};
+    std::vector<Chunk> chunks;
+    std::vector<Color> scratch;
+
+    void           rebuild(Chunk &chunk, int cx, int cy);
+    const Texture &levelTexture(Chunk &chunk, int level);
+};
+
+using SharedTileMapLod = std::shared_ptr<TileMapLod>;
+
+} // namespace sky
+
+#endif
@@ -3,11 +3,77 @@
 #include <mist/moremath.h>
 
 #include <SDL_image.h>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <exception>
+#include <filesystem>
+#include <numeric>
+#include <thread>
 #include <spdlog/spdlog.h>
 
 using namespace sky;
 
+namespace
+{
+
+constexpr int cacheFormatVersion = 1;
+
+/// 64-bit FNV-1a, used for tileset cache file names
+struct Fnv1a {
+    std::uint64_t value {0xcbf29ce484222325u};
+
+    void add(const void *data, std::size_t size)
+    {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            value ^= bytes[i];
+            value *= 0x100000001b3u;
+        }
+    }
+
+    template <class T> void add(const T &v) requires std::is_arithmetic_v<T>
+    {
+        add(&v, sizeof(v));
+    }
+
+    void add(const std::string &s) { add(s.data(), s.size()); }
+};
+
+/// Color of tile i of a ramp from fromValue to toValue in numSteps steps
+std::function<Color(int)> hsvValueColors(float hue, float sat, float fromValue, float toValue,
+                                         int numSteps)
+{
+    return [=](int i) {
+        const auto val = mist::lerp((static_cast<float>(i) / static_cast<float>(numSteps - 1)),
+                                    fromValue, toValue);
+        return sky::hsv(hue, sat, val);
+    };
+}
+
+// Cache keys of painters; {} formats floats in their shortest exact form
+
+std::string colorKey(const Color &c)
+{
+    return spdlog::fmt_lib::format("plainColor {} {} {}", c.r, c.g, c.b);
+}
+
+std::string rampKey(const HSVRamp &ramp)
+{
+    const auto &from = ramp.getFrom();
+    const auto &to = ramp.getTo();
+    return spdlog::fmt_lib::format("hsvRamp {} {} {} {} {} {} {}", ramp.getNumSteps(),
+                                   from.hue, from.sat, from.val, to.hue, to.sat, to.val);
+}
+
+std::string valueRampKey(float hue, float sat, float fromValue, float toValue, int numSteps)
+{
+    return spdlog::fmt_lib::format("hsvValueRamp {} {} {} {} {}", hue, sat, fromValue, toValue,
+                                   numSteps);
+}
+
+} // namespace
+
 /* -------------------------------------------------------------------------- */
 
 Tileset::Tileset(const char *file, int tileSize_) : tileSize(tileSize_)
@@ -22,11 +88,50 @@ Tileset::Tileset(const char *file, int tileSize_) : tileSize(tileSize_)
     assert(tilesPerRow > 0); // NOLINT
 
     texture = Texture {surface};
+    computeTileColors(surface);
 }
 
 Tileset::Tileset(const Surface &surface, int tileSize_)
     : texture(surface), tileSize(tileSize_), tilesPerRow(surface.getWidth() / tileSize)
 {
+    computeTileColors(surface);
+}
+
+void Tileset::computeTileColors(const Surface &surface)
+{
+    // Read through a copy with known byte order: R, G, B, A
+    Surface rgba {SDL_ConvertSurfaceFormat(surface.get(), SDL_PIXELFORMAT_RGBA32, 0)};
+    if (rgba.get() == nullptr) throw SDLError("Convert tileset surface");
+
+    const auto rows = surface.getHeight() / tileSize;
+    tileColors.assign(static_cast<std::size_t>(tilesPerRow * rows), Color {0, 0, 0, 0});
+
+    SDL_LockSurface(rgba.get());
+    const auto *pixels = static_cast<const Uint8 *>(rgba.get()->pixels);
+    const auto  pitch = rgba.get()->pitch;
+
+    for (int tile = 0; tile < tilesPerRow * rows; tile++) {
+        const auto    x0 = (tile % tilesPerRow) * tileSize;
+        const auto    y0 = (tile / tilesPerRow) * tileSize;
+        std::uint64_t sum[4] {0, 0, 0, 0};
+
+        for (int y = y0; y < y0 + tileSize; y++) {
+            const Uint8 *p = pixels + y * pitch + x0 * 4;
+            for (int x = 0; x < tileSize; x++, p += 4) {
+                sum[0] += static_cast<std::uint64_t>(p[0] * p[3]);
+                sum[1] += static_cast<std::uint64_t>(p[1] * p[3]);
+                sum[2] += static_cast<std::uint64_t>(p[2] * p[3]);
+                sum[3] += p[3];
+            }
+        }
+
+        if (sum[3] == 0) continue;
+        const auto numPixels = static_cast<std::uint64_t>(tileSize * tileSize);
+        tileColors[static_cast<std::size_t>(tile)] = {
+            static_cast<Uint8>(sum[0] / sum[3]), static_cast<Uint8>(sum[1] / sum[3]),
+            static_cast<Uint8>(sum[2] / sum[3]), static_cast<Uint8>(sum[3] / numPixels)};
+    }
+    SDL_UnlockSurface(rgba.get());
 }
 
 void Tileset::drawTile(Renderer &renderer, int tileId, SDL_Rect &dest) const
@@ -37,28 +142,130 @@ void Tileset::drawTile(Renderer &renderer, int tileId, SDL_Rect &dest) const
     texture.renderTo(renderer, &src, &dest);
 }
 
+void Tileset::addAnimation(int baseTile, std::vector<int> frames, float frameDuration)
+{
+    if (baseTile < 0 || frames.empty() || frameDuration <= 0) {
+        throw std::runtime_error("Tile animation: invalid definition");
+    }
+
+    const auto base = static_cast<std::size_t>(baseTile);
+    if (base >= frameTable.size()) {
+        const auto oldSize = static_cast<int>(frameTable.size());
+        frameTable.resize(base + 1);
+        std::iota(frameTable.begin() + oldSize, frameTable.end(), oldSize);
+    }
+
+    if (base >= animated.size()) animated.resize(base + 1, false);
+
+    frameTable[base] = frames.front();
+    if (animated[base]) {
+        auto it = std::find_if(animations.begin(), animations.end(),
+                               [baseTile](const Animation &a) { return a.baseTile == baseTile; });
+        *it = {baseTile, std::move(frames), frameDuration, 0};
+    } else {
+        animated[base] = true;
+        animations.push_back({baseTile, std::move(frames), frameDuration, 0});
+    }
+    frameVersion++;
+}
+
+bool Tileset::update(float dt)
+{
+    bool changed = false;
+    for (auto &a : animations) {
+        // Keep time within a single loop, so it does not lose precision over a long run
+        const auto loopTime = a.frameDuration * static_cast<float>(a.frames.size());
+        a.time = std::fmod(a.time + dt, loopTime);
+
+        const auto frame =
+            std::min(static_cast<std::size_t>(a.time / a.frameDuration), a.frames.size() - 1);
+        auto &current = frameTable[static_cast<std::size_t>(a.baseTile)];
+        if (current != a.frames[frame]) {
+            current = a.frames[frame];
+            changed = true;
+        }
+    }
+
+    if (changed) frameVersion++;
+    return changed;
+}
+
 /* -------------------------------------------------------------------------- */
 
 TilesetBuilder::TilesetBuilder(int tileSize_) : tileSize(tileSize_)
 {
 }
 
-TilesetBuilder &TilesetBuilder::addSequence(int count, const TilePainter &painter)
+TilesetBuilder &TilesetBuilder::addSequence(int count, const TilePainter &painter,
+                                            std::string_view cacheKey)
+{
+    numTiles += count;
+    nodes.emplace_back(Node {count, painter, nullptr,
+                             cacheKey.empty() ? painter.getCacheKey() : std::string(cacheKey)});
+
+    return *this;
+}
+
+TilesetBuilder &TilesetBuilder::addTile(const TilePainter &painter, std::string_view cacheKey)
+{
+    addSequence(1, painter, cacheKey);
+    return *this;
+}
+
+TilesetBuilder &TilesetBuilder::addPixelSequence(int count, const PixelPainter &painter,
+                                                 std::string_view cacheKey)
 {
     numTiles += count;
-    nodes.emplace_back(Node {count, painter});
+    nodes.emplace_back(Node {count, nullptr, painter,
+                             cacheKey.empty() ? painter.getCacheKey() : std::string(cacheKey)});
 
     return *this;
 }
 
-TilesetBuilder &TilesetBuilder::addTile(const TilePainter &painter)
+TilesetBuilder &TilesetBuilder::addPixelTile(const PixelPainter &painter,
+                                             std::string_view cacheKey)
 {
-    addSequence(1, painter);
+    addPixelSequence(1, painter, cacheKey);
+    return *this;
+}
+
+TilesetBuilder &TilesetBuilder::setCacheDirectory(std::string directory)
+{
+    cacheDirectory = std::move(directory);
+    return *this;
+}
+
+std::string TilesetBuilder::getCacheFile() const
+{
+    if (cacheDirectory.empty() || nodes.empty()) return {};
+
+    Fnv1a hash;
+    hash.add(cacheFormatVersion);
+    hash.add(tileSize);
+    for (const auto &node : nodes) {
+        if (node.cacheKey.empty()) return {};
+        hash.add(node.count);
+        hash.add(node.pixelPainter ? 1 : 0);
+        hash.add(node.cacheKey.size());
+        hash.add(node.cacheKey);
+    }
+
+    return cacheDirectory + "/tileset-" + spdlog::fmt_lib::format("{:016x}", hash.value) + ".png";
+}
+
+TilesetBuilder &TilesetBuilder::setNumThreads(int n)
+{
+    numThreads = n > 0 ? n : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
     return *this;
 }
 
 SharedTileset TilesetBuilder::build()
 {
+    const auto cacheFile = surface == nullptr ? getCacheFile() : std::string {};
+    if (!cacheFile.empty() && loadFromCache(cacheFile)) {
+        return std::make_shared<Tileset>(*surface, tileSize);
+    }
+
     if (surface == nullptr) {
         surface = std::make_unique<Surface>(tileSize * numTiles, tileSize, 32);
         renderer = Renderer(SDL_CreateSoftwareRenderer(surface->get()));
@@ -67,16 +274,120 @@ SharedTileset TilesetBuilder::build()
     renderer.setDrawColor(Color {0, 0, 0, 255});
     renderer.clear();
 
+    const auto threads = std::min(numThreads, numTiles);
+    if (threads > 1)
+        buildParallel(threads);
+    else
+        paintTiles(renderer, surface->get(), 0, numTiles, nodes);
+
+    if (!cacheFile.empty()) {
+        try {
+            std::filesystem::create_directories(cacheDirectory);
+            surface->saveToFile(cacheFile.c_str());
+        } catch (std::exception &e) {
+            spdlog::warn("Tileset cache: cannot store {}: {}", cacheFile, e.what());
+        }
+    }
+
+    return std::make_shared<Tileset>(*surface, tileSize);
+}
+
+bool TilesetBuilder::loadFromCache(const std::string &file)
+{
+    if (!std::filesystem::exists(file)) return false;
+
+    try {
+        auto loaded = Surface::fromFile(file.c_str());
+        if (loaded.getWidth() != tileSize * numTiles || loaded.getHeight() != tileSize) {
+            spdlog::warn("Tileset cache: size mismatch in {}", file);
+            return false;
+        }
+
+        // Same pixel format as a built tileset, so drawTile() and export keep working
+        auto *converted = SDL_ConvertSurfaceFormat(loaded.get(), SDL_PIXELFORMAT_RGBA32, 0);
+        if (converted == nullptr) throw SDLError("Convert cached tileset");
+
+        surface = std::make_unique<Surface>(converted);
+        renderer = Renderer(SDL_CreateSoftwareRenderer(surface->get()));
+    } catch (std::exception &e) {
+        spdlog::warn("Tileset cache: cannot load {}: {}", file, e.what());
+        surface.reset();
+        return false;
+    }
+
+    spdlog::debug("Tileset cache: loaded {}", file);
+    return true;
+}
+
+/// Paint tiles [first, last) of the whole tileset, with tile `first` at x = 0 of target
+void TilesetBuilder::paintTiles(Renderer &target, SDL_Surface *targetSurface, int first, int last,
+                                const std::vector<Node> &painters) const
+{
     int startingTile = 0;
-    for (const auto &node : nodes) {
-        for (int i = 0; i < node.count; i++) {
-            SDL_Rect rect {(startingTile + i) * tileSize, 0, tileSize, tileSize};
-            node.painter(renderer, &rect, i);
+    for (const auto &node : painters) {
+        const auto from = std::max(first, startingTile);
+        const auto to = std::min(last, startingTile + node.count);
+        if (from < to && node.pixelPainter && SDL_LockSurface(targetSurface) != 0) {
+            throw SDLError("Lock tileset surface");
         }
+
+        for (int tile = from; tile < to; tile++) {
+            SDL_Rect rect {(tile - first) * tileSize, 0, tileSize, tileSize};
+            if (node.pixelPainter)
+                node.pixelPainter(PixelSpan::of(targetSurface, rect), tile - startingTile);
+            else
+                node.painter(target, &rect, tile - startingTile);
+        }
+
+        if (from < to && node.pixelPainter) SDL_UnlockSurface(targetSurface);
         startingTile += node.count;
     }
+}
 
-    return std::make_shared<Tileset>(*surface, tileSize);
+void TilesetBuilder::buildParallel(int threads)
+{
+    struct Part {
+        int                      first;
+        int                      last;
+        std::unique_ptr<Surface> surface;
+        std::exception_ptr       error;
+    };
+
+    std::vector<Part> parts(static_cast<size_t>(threads));
+    for (int i = 0; i < threads; i++) {
+        auto &part = parts[static_cast<size_t>(i)];
+        part.first = numTiles * i / threads;
+        part.last = numTiles * (i + 1) / threads;
+    }
+
+    std::vector<std::thread> workers;
+    for (auto &part : parts) {
+        workers.emplace_back([this, &part] {
+            try {
+                const auto painters = nodes;
+                part.surface =
+                    std::make_unique<Surface>(tileSize * (part.last - part.first), tileSize, 32);
+                Renderer partRenderer(SDL_CreateSoftwareRenderer(part.surface->get()));
+                partRenderer.setDrawColor(Color {0, 0, 0, 255});
+                partRenderer.clear();
+                paintTiles(partRenderer, part.surface->get(), part.first, part.last, painters);
+            } catch (...) {
+                part.error = std::current_exception();
+            }
+        });
+    }
+    for (auto &t : workers)
+        t.join();
+
+    for (auto &part : parts) {
+        if (part.error) std::rethrow_exception(part.error);
+
+        SDL_SetSurfaceBlendMode(part.surface->get(), SDL_BLENDMODE_NONE);
+        SDL_Rect dest {part.first * tileSize, 0, (part.last - part.first) * tileSize, tileSize};
+        if (SDL_BlitSurface(part.surface->get(), nullptr, surface->get(), &dest) != 0) {
+            throw SDLError("Copy tileset part");
+        }
+    }
 }
 
 auto TilesetBuilder::drawTile(int tileId, int painterArg, const TilePainter &painter) -> void
@@ -110,52 +421,78 @@ TilesetBuilder::TilePainter TilePainters::plainColor(const TileToColor f)
 
 TilesetBuilder::TilePainter TilePainters::plainColor(const Color &color)
 {
-    return [=](Renderer &renderer, SDL_Rect *rect, int) {
-        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 0xFF);
-        SDL_RenderFillRect(renderer, rect);
-    };
+    return {[=](Renderer &renderer, SDL_Rect *rect, int) {
+                SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 0xFF);
+                SDL_RenderFillRect(renderer, rect);
+            },
+            colorKey(color)};
 }
 
 TilesetBuilder::TilePainter TilePainters::plainColor(const HSVRamp &ramp)
 {
-    return [=](Renderer &renderer, SDL_Rect *rect, int tile) {
-        const auto color = ramp.get(tile);
-        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 0xFF);
-        SDL_RenderFillRect(renderer, rect);
-    };
+    return {[=](Renderer &renderer, SDL_Rect *rect, int tile) {
+                const auto color = ramp.get(tile);
+                SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 0xFF);
+                SDL_RenderFillRect(renderer, rect);
+            },
+            rampKey(ramp)};
 }
 
 auto TilePainters::hsvValueRamp(float hue, float sat, float fromValue, float toValue, int numSteps)
     -> TilesetBuilder::TilePainter
 {
-    return plainColor([=](int i) {
-        const auto val = mist::lerp((static_cast<float>(i) / static_cast<float>(numSteps - 1)),
-                                    fromValue, toValue);
-        return sky::hsv(hue, sat, val);
-    });
+    return {plainColor(hsvValueColors(hue, sat, fromValue, toValue, numSteps)),
+            valueRampKey(hue, sat, fromValue, toValue, numSteps)};
 }
 
 /* -------------------------------------------------------------------------- */
 
-void TileDrawable::draw(Renderer &renderer, int x, int y, double)
+TilesetBuilder::PixelPainter PixelPainters::plainColor(const TileToColor f)
 {
-    auto     tileSize = tileset.getTileSize();
-    SDL_Rect destRect {x, y, tileSize, tileSize};
-    tileset.drawTile(renderer, tile, destRect);
+    return [=](const PixelSpan &span, int tile) { PixelKernels::fill(span, f(tile)); };
+}
+
+TilesetBuilder::PixelPainter PixelPainters::plainColor(const Color &color)
+{
+    return {[=](const PixelSpan &span, int) { PixelKernels::fill(span, color); },
+            colorKey(color)};
+}
+
+auto PixelPainters::hsvValueRamp(float hue, float sat, float fromValue, float toValue,
+                                 int numSteps) -> TilesetBuilder::PixelPainter
+{
+    return {plainColor(hsvValueColors(hue, sat, fromValue, toValue, numSteps)),
+            valueRampKey(hue, sat, fromValue, toValue, numSteps)};
+}
+
+TilesetBuilder::PixelPainter PixelPainters::verticalGradient(const TileToColor from,
+                                                             const TileToColor to)
+{
+    return [=](const PixelSpan &span, int tile) {
+        PixelKernels::verticalGradient(span, from(tile), to(tile));
+    };
+}
+
+TilesetBuilder::PixelPainter PixelPainters::ditherGradient(const TileToColor from,
+                                                           const TileToColor to)
+{
+    return [=](const PixelSpan &span, int tile) {
+        PixelKernels::ditherGradient(span, from(tile), to(tile));
+    };
+}
+
+TilesetBuilder::PixelPainter PixelPainters::noise(const TileToColor f, Uint8 amount, Uint32 seed)
+{
+    return [=](const PixelSpan &span, int tile) {
+        PixelKernels::noise(span, f(tile), amount, seed + static_cast<Uint32>(tile));
+    };
 }
 
 /* -------------------------------------------------------------------------- */
 
-void TileMap::draw(Renderer &renderer, int x, int y, double)
+void TileDrawable::draw(Renderer &renderer, int x, int y, double)
 {
-    auto     tileSize = tileset->getTileSize();
+    auto     tileSize = tileset.getTileSize();
     SDL_Rect destRect {x, y, tileSize, tileSize};
-
-    for (int iy = 0; iy < height; iy++) {
-        for (int ix = 0; ix < width; ix++) {
-            destRect.x = x + tileSize * ix;
-            destRect.y = y + tileSize * iy;
-            tileset->drawTile(renderer, tiles[iy * width + ix], destRect);
-        }
-    }
+    tileset.drawTile(renderer, tileset.resolveTile(tile), destRect);
 }
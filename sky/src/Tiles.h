@@ -2,11 +2,22 @@
 #define SDLPP_TILES_H_
 
 #include "Color.h"
+#include "Pixels.h"
 #include "SkyEngine.h"
 #include <mist/Point.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace sky
@@ -20,6 +31,10 @@ namespace sky
  *
  * Tiles are identified with a single int tileId, counting from 0 in positive X direction,
  * wrapping to the next row after tilesPerRow tiles.
+ *
+ * A tile can be animated with addAnimation(): maps keep storing the base tile, and draw the
+ * current frame by looking it up with resolveTile(). Call update() once per frame to advance
+ * all animations of the tileset; map data never changes.
  */
 class Tileset
 {
@@ -31,16 +46,114 @@ public:
 
     void drawTile(Renderer &renderer, int tileId, SDL_Rect &dest) const;
 
+    /// @brief Average color of a tile, weighted by alpha; used for zoomed-out maps
+    [[nodiscard]] Color getTileColor(int tileId) const noexcept
+    {
+        const auto i = static_cast<std::size_t>(tileId);
+        return i < tileColors.size() ? tileColors[i] : Color {0, 0, 0, 0};
+    }
+
+    /**
+     * @brief Show a sequence of tiles in place of baseTile
+     *
+     * Replaces any animation defined before for baseTile.
+     *
+     * @arg frames tile ids of the frames, played in a loop
+     * @arg frameDuration in seconds
+     */
+    void addAnimation(int baseTile, std::vector<int> frames, float frameDuration);
+
+    /**
+     * @brief Advance all animations
+     *
+     * @return true if any animated tile shows a different frame than before
+     */
+    bool update(float dt);
+
+    [[nodiscard]] bool isAnimated(int tileId) const noexcept
+    {
+        const auto i = static_cast<std::size_t>(tileId);
+        return i < animated.size() && animated[i];
+    }
+
+    /// @brief Tile to draw for tileId in the current frame
+    [[nodiscard]] int resolveTile(int tileId) const noexcept
+    {
+        const auto i = static_cast<std::size_t>(tileId);
+        return i < frameTable.size() ? frameTable[i] : tileId;
+    }
+
+    /**
+     * @brief Incremented by update() whenever an animated tile changes its frame
+     *
+     * Caches of rendered tiles only need to redraw areas with animated tiles when this changes.
+     */
+    [[nodiscard]] std::uint32_t getFrameVersion() const noexcept { return frameVersion; }
+
 private:
     Texture texture;
     int     tileSize;
     int     tilesPerRow;
+
+    std::vector<Color> tileColors;
+
+    void computeTileColors(const Surface &surface);
+
+    struct Animation {
+        int              baseTile;
+        std::vector<int> frames;
+        float            frameDuration;
+        float            time;
+    };
+
+    std::vector<Animation> animations;
+    std::vector<int>       frameTable; ///< tile to draw, indexed by tile id; identity if static
+    std::vector<bool>      animated;   ///< base tiles of animations, indexed by tile id
+    std::uint32_t          frameVersion {0};
 };
 
 using SharedTileset = std::shared_ptr<Tileset>;
 
 // -----------------------------------------------------------------------------
 
+/**
+ * @brief A painter function with a cache key describing it and all its parameters
+ *
+ * Painters made by TilePainters and PixelPainters from plain values carry a key built from
+ * those values, so a changed argument always changes the key. Painters made from arbitrary
+ * functions, including lambdas, have an empty key. See TilesetBuilder::setCacheDirectory().
+ */
+template <class Signature> class KeyedPainter
+{
+public:
+    KeyedPainter() = default;
+
+    template <class F>
+    requires(!std::is_same_v<std::remove_cvref_t<F>, KeyedPainter> &&
+             std::is_constructible_v<std::function<Signature>, F>)
+    KeyedPainter(F f) : function(std::move(f)) // NOLINT(google-explicit-constructor)
+    {
+    }
+
+    KeyedPainter(std::function<Signature> f, std::string key)
+        : function(std::move(f)), cacheKey(std::move(key))
+    {
+    }
+
+    template <class... Args> void operator()(Args &&...args) const
+    {
+        function(std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept { return static_cast<bool>(function); }
+
+    [[nodiscard]] const std::string &getCacheKey() const noexcept { return cacheKey; }
+
+private:
+    std::function<Signature> function;
+    std::string              cacheKey;
+};
+
 /// @brief A utility for making procedurally generated tilesets
 class TilesetBuilder
 {
@@ -63,10 +176,57 @@ public:
      * @arg rect coordinates of the tile to paint
      * @arg int index of the tile in sequence
      */
-    using TilePainter = std::function<void(Renderer &renderer, SDL_Rect *rect, int index)>;
+    using TilePainter = KeyedPainter<void(Renderer &renderer, SDL_Rect *rect, int index)>;
+
+    /**
+     * @arg cacheKey describes the painter and all its parameters, see setCacheDirectory();
+     * overrides the key of the painter, only needed for painters without one
+     */
+    TilesetBuilder &addSequence(int count, const TilePainter &painter,
+                                std::string_view cacheKey = {});
+    TilesetBuilder &addTile(const TilePainter &painter, std::string_view cacheKey = {});
+
+    /**
+     * @brief Tile Painter writing pixels directly, for sequences added with addPixelSequence()
+     *
+     * Works like TilePainter, but instead of a renderer and a rect, the painter gets the
+     * pixels of the tile in the locked tileset surface. See PixelKernels for fast fills.
+     *
+     * @arg span pixels of the tile to paint
+     * @arg int index of the tile in sequence
+     */
+    using PixelPainter = KeyedPainter<void(const PixelSpan &span, int index)>;
+
+    TilesetBuilder &addPixelSequence(int count, const PixelPainter &painter,
+                                     std::string_view cacheKey = {});
+    TilesetBuilder &addPixelTile(const PixelPainter &painter, std::string_view cacheKey = {});
 
-    TilesetBuilder &addSequence(int count, const TilePainter &painter);
-    TilesetBuilder &addTile(const TilePainter &painter);
+    /**
+     * @brief Number of threads used by build()
+     *
+     * With more than one thread, tiles are split into contiguous ranges, each painted by its
+     * own software renderer into a separate surface, which are then copied into the tileset.
+     * Each thread works on its own copies of the painters. The result is identical to the
+     * serial build, as long as painters only draw inside the given rect.
+     *
+     * @arg n number of threads; 0 uses the number of hardware threads
+     */
+    TilesetBuilder &setNumThreads(int n);
+
+    /**
+     * @brief Cache built tilesets as PNG files in a directory
+     *
+     * The cache file name is a hash of the tile size and of the count, painter type and cache
+     * key of every sequence. If a matching file exists, build() loads it instead of painting.
+     * Otherwise the built tileset is stored there. Caching is only used when every sequence
+     * has a non-empty cache key: painters from TilePainters and PixelPainters built from
+     * plain values carry their own, other painters need one passed to addSequence(), which
+     * must change whenever the painter output changes.
+     */
+    TilesetBuilder &setCacheDirectory(std::string directory);
+
+    /// @brief Path of the cache file for the current sequences, empty if not cacheable
+    [[nodiscard]] std::string getCacheFile() const;
 
     void drawTile(int tileId, int painterArg, const TilePainter &painter);
 
@@ -75,16 +235,26 @@ public:
 private:
     int tileSize;
     int numTiles {0};
+    int numThreads {1};
+
+    std::string cacheDirectory;
 
     std::unique_ptr<Surface> surface;
     Renderer                 renderer;
 
     struct Node {
-        int         count;
-        TilePainter painter;
+        int          count;
+        TilePainter  painter;
+        PixelPainter pixelPainter;
+        std::string  cacheKey;
     };
 
     std::vector<Node> nodes;
+
+    void paintTiles(Renderer &target, SDL_Surface *targetSurface, int first, int last,
+                    const std::vector<Node> &painters) const;
+    void buildParallel(int threads);
+    bool loadFromCache(const std::string &file);
 };
 
 /// @brief A collection of tile generation functions for TilesetBuilder
@@ -100,6 +270,22 @@ auto hsvValueRamp(float hue, float sat, float fromValue, float toValue, int numS
     -> TilesetBuilder::TilePainter;
 } // namespace TilePainters
 
+/// @brief A collection of pixel-level tile generation functions for TilesetBuilder
+namespace PixelPainters
+{
+using TileToColor = std::function<Color(int)>;
+
+TilesetBuilder::PixelPainter plainColor(const TileToColor f);
+TilesetBuilder::PixelPainter plainColor(const Color &color);
+
+auto hsvValueRamp(float hue, float sat, float fromValue, float toValue, int numSteps)
+    -> TilesetBuilder::PixelPainter;
+
+TilesetBuilder::PixelPainter verticalGradient(const TileToColor from, const TileToColor to);
+TilesetBuilder::PixelPainter ditherGradient(const TileToColor from, const TileToColor to);
+TilesetBuilder::PixelPainter noise(const TileToColor f, Uint8 amount, Uint32 seed = 0);
+} // namespace PixelPainters
+
 /* -------------------------------------------------------------------------- */
 
 /// @brief A Drawable that renders a single tile
@@ -122,44 +308,382 @@ private:
 
 /* -------------------------------------------------------------------------- */
 
-/// @brief A Drawable grid of tiles from a single Tileset
-class TileMap : public Drawable
+/// @brief Conventional layer indices for multi-layer TileMaps
+struct TileLayer {
+    static constexpr int Ground = 0;
+    static constexpr int Decoration = 1;
+    static constexpr int Collision = 2;
+};
+
+/// @brief Memory used by a TileMap
+struct TileMapMemory {
+    std::size_t cellBytes;  ///< size of a single cell
+    std::size_t layerBytes; ///< size of a single layer
+    std::size_t totalBytes; ///< size of all layers
+    int         numLayers;
+    bool        external; ///< storage is not owned by the map, e.g. memory-mapped
+};
+
+/// @brief Areas touched by BasicTileMap::moveRect(), in tiles
+struct TileMapMove {
+    SDL_Rect from; ///< vacated area, in the source map
+    SDL_Rect to;   ///< written area, in the destination map
+};
+
+/**
+ * @brief A Drawable grid of tiles from a single Tileset
+ *
+ * The map is templated on the cell type, so that maps using small tilesets can be stored
+ * with 1 or 2 bytes per cell. All layers are stored in a single contiguous buffer, one layer
+ * after another, each layer in row-major order. The buffer is either owned by the map or
+ * provided externally, e.g. a memory-mapped file (see TileMapFile).
+ *
+ * Layers are drawn in order, starting from layer 0. Cells holding the Empty value are
+ * skipped; layers other than 0 start out empty. Animated tiles are drawn with the current
+ * frame of the Tileset. Layers that only hold data, like a collision layer, can be hidden
+ * with setLayerVisible().
+ */
+template <class Cell> class BasicTileMap : public Drawable
 {
+    static_assert(std::is_unsigned_v<Cell> || std::is_same_v<Cell, int>,
+                  "TileMap cell must be an unsigned integer or int");
+
 public:
-    TileMap(SharedTileset tileset_, int width_, int height_)
-        : tileset(std::move(tileset_)), width(width_), height(height_), tiles(width * height)
+    using CellType = Cell;
+
+    /// Reserved for empty cells; the largest tile id a map can hold is one less, e.g. 254
+    /// for TileMap8
+    static constexpr Cell Empty = std::numeric_limits<Cell>::max();
+
+    BasicTileMap(SharedTileset tileset_, int width_, int height_, int numLayers_ = 1)
+        : tileset(std::move(tileset_)), width(width_), height(height_), numLayers(numLayers_),
+          ownedTiles(cellCount(width_, height_, numLayers_), Cell {0}), tiles(ownedTiles),
+          visibleLayers(static_cast<std::size_t>(numLayers), true)
+    {
+        std::fill(tiles.begin() + layerOffset(1), tiles.end(), Empty);
+    }
+
+    /**
+     * @brief Create a map on top of external cell storage
+     *
+     * @arg storage width * height * numLayers cells, laid out as described above
+     * @arg storageOwner keeps the storage alive for the lifetime of the map
+     */
+    BasicTileMap(SharedTileset tileset_, int width_, int height_, int numLayers_,
+                 std::span<Cell> storage, std::shared_ptr<void> storageOwner)
+        : tileset(std::move(tileset_)), width(width_), height(height_), numLayers(numLayers_),
+          externalTiles(std::move(storageOwner)),
+          tiles(checkedStorage(storage, width_, height_, numLayers_)),
+          visibleLayers(static_cast<std::size_t>(numLayers), true)
+    {
+    }
+
+    BasicTileMap(const BasicTileMap &other)
+        : Drawable(other), tileset(other.tileset), width(other.width), height(other.height),
+          numLayers(other.numLayers), ownedTiles(other.tiles.begin(), other.tiles.end()),
+          tiles(ownedTiles), visibleLayers(other.visibleLayers)
     {
     }
 
-    void fill(int x)
+    BasicTileMap(BasicTileMap &&) noexcept = default;
+    BasicTileMap &operator=(const BasicTileMap &) = delete;
+    BasicTileMap &operator=(BasicTileMap &&) = delete;
+    ~BasicTileMap() override = default;
+
+    void fill(Cell x) { fill(0, x); }
+
+    void fill(int layer, Cell x)
     {
-        for (auto &i : tiles)
-            i = x;
+        auto cells = getLayer(layer);
+        std::fill(cells.begin(), cells.end(), x);
     }
 
     [[nodiscard]] int getWidth() const noexcept { return width; }
 
     [[nodiscard]] int getHeight() const noexcept { return height; }
 
+    [[nodiscard]] int getNumLayers() const noexcept { return numLayers; }
+
     [[nodiscard]] int getTileSize() const noexcept { return tileset->getTileSize(); }
 
-    [[nodiscard]] int &operator[](const mist::Point2i &p) { return tiles[p.y * width + p.x]; }
+    [[nodiscard]] const SharedTileset &getTileset() const noexcept { return tileset; }
 
-    [[nodiscard]] int operator[](const mist::Point2i &p) const { return tiles[p.y * width + p.x]; }
+    [[nodiscard]] Cell &operator[](const mist::Point2i &p) { return tiles[index(0, p)]; }
 
-    [[nodiscard]] int &at(const mist::Point2i &p) { return tiles[p.y * width + p.x]; }
+    [[nodiscard]] Cell operator[](const mist::Point2i &p) const { return tiles[index(0, p)]; }
 
-    [[nodiscard]] int at(const mist::Point2i &p) const { return tiles[p.y * width + p.x]; }
+    [[nodiscard]] Cell &at(const mist::Point2i &p) { return tiles[index(0, p)]; }
 
-    void draw(Renderer &renderer, int x, int y, double) override;
+    [[nodiscard]] Cell at(const mist::Point2i &p) const { return tiles[index(0, p)]; }
+
+    [[nodiscard]] Cell &at(int layer, const mist::Point2i &p) { return tiles[index(layer, p)]; }
+
+    [[nodiscard]] Cell at(int layer, const mist::Point2i &p) const
+    {
+        return tiles[index(layer, p)];
+    }
+
+    /// @brief All cells of all layers
+    [[nodiscard]] std::span<Cell> getCells() noexcept { return tiles; }
+
+    [[nodiscard]] std::span<const Cell> getCells() const noexcept { return tiles; }
+
+    [[nodiscard]] std::span<Cell> getLayer(int layer)
+    {
+        return tiles.subspan(static_cast<std::size_t>(layerOffset(layer)), layerSize());
+    }
+
+    [[nodiscard]] std::span<const Cell> getLayer(int layer) const
+    {
+        return tiles.subspan(static_cast<std::size_t>(layerOffset(layer)), layerSize());
+    }
+
+    void setLayerVisible(int layer, bool visible)
+    {
+        visibleLayers[static_cast<std::size_t>(layer)] = visible;
+    }
+
+    [[nodiscard]] bool isLayerVisible(int layer) const
+    {
+        return visibleLayers[static_cast<std::size_t>(layer)];
+    }
+
+    [[nodiscard]] TileMapMemory getMemoryUsage() const noexcept
+    {
+        return {sizeof(Cell), layerSize() * sizeof(Cell), tiles.size() * sizeof(Cell),
+                numLayers, externalTiles != nullptr};
+    }
+
+    /* ---------------------------------------------------------------------- */
+    // Bulk region operations
+    //
+    // Areas are clipped to the maps; the returned rect is the area actually written, in tiles,
+    // and is empty (all zeros) if nothing was written. Rows are processed as contiguous
+    // memory, so these are much faster than the equivalent loops over at().
+
+    SDL_Rect fillRect(int layer, SDL_Rect area, Cell value)
+    {
+        SDL_Rect bounds {0, 0, width, height};
+        if (!SDL_IntersectRect(&area, &bounds, &area)) return {0, 0, 0, 0};
+
+        Cell *row = tiles.data() + index(layer, {area.x, area.y});
+        for (int y = 0; y < area.h; y++, row += width)
+            std::fill_n(row, area.w, value);
+        return area;
+    }
+
+    /**
+     * @brief Copy an area of a layer of src to this map, with its top left corner at dest
+     *
+     * src may be this map, and the areas may overlap.
+     */
+    SDL_Rect copyRect(const BasicTileMap &src, int srcLayer, SDL_Rect area, int layer,
+                      mist::Point2i dest)
+    {
+        if (!clipCopy(src, area, dest)) return {0, 0, 0, 0};
+
+        const Cell *from = src.tiles.data() + src.index(srcLayer, {area.x, area.y});
+        Cell       *to = tiles.data() + index(layer, dest);
+        const auto  rowBytes = static_cast<std::size_t>(area.w) * sizeof(Cell);
+
+        // With overlapping areas in one buffer, rows must not be overwritten before being read
+        if (std::less<const Cell *> {}(from, to)) {
+            for (int y = area.h - 1; y >= 0; y--)
+                std::memmove(to + y * width, from + y * src.width, rowBytes);
+        } else {
+            for (int y = 0; y < area.h; y++)
+                std::memmove(to + y * width, from + y * src.width, rowBytes);
+        }
+        return {dest.x, dest.y, area.w, area.h};
+    }
+
+    /**
+     * @brief Like copyRect(), but cells of src holding the transparent value are skipped
+     *
+     * Useful for stamping prefabs. The areas must not overlap when src is this map.
+     */
+    SDL_Rect blit(const BasicTileMap &src, int srcLayer, SDL_Rect area, int layer,
+                  mist::Point2i dest, Cell transparent = Empty)
+    {
+        if (!clipCopy(src, area, dest)) return {0, 0, 0, 0};
+
+        const Cell *from = src.tiles.data() + src.index(srcLayer, {area.x, area.y});
+        Cell       *to = tiles.data() + index(layer, dest);
+        for (int y = 0; y < area.h; y++, from += src.width, to += width) {
+            for (int x = 0; x < area.w; x++)
+                to[x] = from[x] == transparent ? to[x] : from[x];
+        }
+        return {dest.x, dest.y, area.w, area.h};
+    }
+
+    /**
+     * @brief Copy an area like copyRect(), then fill the vacated source cells
+     *
+     * Source cells covered by the copied area, when src is this map, keep the copied values.
+     */
+    TileMapMove moveRect(BasicTileMap &src, int srcLayer, SDL_Rect area, int layer,
+                         mist::Point2i dest, Cell vacated = Empty)
+    {
+        if (!clipCopy(src, area, dest)) return {{0, 0, 0, 0}, {0, 0, 0, 0}};
+        const SDL_Rect to = copyRect(src, srcLayer, area, layer, dest);
+
+        const bool sameLayer = &src == this && srcLayer == layer;
+        Cell      *row = src.tiles.data() + src.index(srcLayer, {area.x, area.y});
+        for (int y = area.y; y < area.y + area.h; y++, row += src.width) {
+            if (!sameLayer || y < to.y || y >= to.y + to.h) {
+                std::fill_n(row, area.w, vacated);
+                continue;
+            }
+            // Only the parts of the row left and right of the copied area
+            const auto keepBegin = std::clamp(to.x - area.x, 0, area.w);
+            const auto keepEnd = std::clamp(to.x + to.w - area.x, 0, area.w);
+            std::fill(row, row + keepBegin, vacated);
+            std::fill(row + keepEnd, row + area.w, vacated);
+        }
+        return {area, to};
+    }
+
+    /**
+     * @brief Replace the 4-connected region of equal cells around seed with value
+     *
+     * Scanline fill: every row span is found and filled at once, and only one seed per span
+     * of matching cells above and below is queued.
+     */
+    SDL_Rect floodFill(int layer, const mist::Point2i &seed, Cell value)
+    {
+        if (seed.x < 0 || seed.y < 0 || seed.x >= width || seed.y >= height) return {0, 0, 0, 0};
+
+        Cell      *cells = tiles.data() + layerOffset(layer);
+        const Cell target = cells[seed.y * width + seed.x];
+        if (target == value) return {0, 0, 0, 0};
+
+        auto minX = seed.x;
+        auto maxX = seed.x;
+        auto minY = seed.y;
+        auto maxY = seed.y;
+
+        std::vector<mist::Point2i> pending {seed};
+        while (!pending.empty()) {
+            const auto p = pending.back();
+            pending.pop_back();
+
+            Cell *row = cells + p.y * width;
+            if (row[p.x] != target) continue;
+
+            auto left = p.x;
+            auto right = p.x;
+            while (left > 0 && row[left - 1] == target)
+                left--;
+            while (right < width - 1 && row[right + 1] == target)
+                right++;
+            std::fill(row + left, row + right + 1, value);
+
+            minX = std::min(minX, left);
+            maxX = std::max(maxX, right);
+            minY = std::min(minY, p.y);
+            maxY = std::max(maxY, p.y);
+
+            for (const auto ny : {p.y - 1, p.y + 1}) {
+                if (ny < 0 || ny >= height) continue;
+                const Cell *adjacent = cells + ny * width;
+                for (int x = left; x <= right; x++) {
+                    if (adjacent[x] == target && (x == left || adjacent[x - 1] != target))
+                        pending.push_back({x, ny});
+                }
+            }
+        }
+        return {minX, minY, maxX - minX + 1, maxY - minY + 1};
+    }
+
+    void draw(Renderer &renderer, int x, int y, double) override
+    {
+        auto     tileSize = tileset->getTileSize();
+        SDL_Rect destRect {x, y, tileSize, tileSize};
+
+        for (int layer = 0; layer < numLayers; layer++) {
+            if (!isLayerVisible(layer)) continue;
+
+            const Cell *cell = tiles.data() + layerOffset(layer);
+            for (int iy = 0; iy < height; iy++) {
+                for (int ix = 0; ix < width; ix++, cell++) {
+                    if (*cell == Empty) continue;
+                    destRect.x = x + tileSize * ix;
+                    destRect.y = y + tileSize * iy;
+                    tileset->drawTile(renderer, tileset->resolveTile(static_cast<int>(*cell)),
+                                      destRect);
+                }
+            }
+        }
+    }
 
 private:
-    SharedTileset    tileset;
-    const int        width;
-    const int        height;
-    std::vector<int> tiles;
+    SharedTileset         tileset;
+    const int             width;
+    const int             height;
+    const int             numLayers;
+    std::vector<Cell>     ownedTiles;
+    std::shared_ptr<void> externalTiles;
+    std::span<Cell>       tiles;
+    std::vector<bool>     visibleLayers;
+
+    /// Number of cells of a map, checking the dimensions before anything is allocated
+    static std::size_t cellCount(int w, int h, int layers)
+    {
+        if (w <= 0 || h <= 0 || layers <= 0) {
+            throw std::runtime_error("Tile map: dimensions and layer count must be positive");
+        }
+        return static_cast<std::size_t>(w) * static_cast<std::size_t>(h) *
+               static_cast<std::size_t>(layers);
+    }
+
+    static std::span<Cell> checkedStorage(std::span<Cell> storage, int w, int h, int layers)
+    {
+        if (storage.size() < cellCount(w, h, layers)) {
+            throw std::runtime_error("Tile map: storage too small");
+        }
+        return storage;
+    }
+
+    [[nodiscard]] std::size_t layerSize() const noexcept
+    {
+        return static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    }
+
+    [[nodiscard]] std::ptrdiff_t layerOffset(int layer) const noexcept
+    {
+        return static_cast<std::ptrdiff_t>(layerSize()) * layer;
+    }
+
+    [[nodiscard]] std::size_t index(int layer, const mist::Point2i &p) const noexcept
+    {
+        return static_cast<std::size_t>(layerOffset(layer) +
+                                        static_cast<std::ptrdiff_t>(p.y) * width + p.x);
+    }
+
+    /// Clip a copy from area of src to dest of this map, keeping both in sync
+    bool clipCopy(const BasicTileMap &src, SDL_Rect &area, mist::Point2i &dest) const noexcept
+    {
+        auto clipStart = [](int &from, int &to, int &size) {
+            const auto shift = std::max({0, -from, -to});
+            from += shift;
+            to += shift;
+            size -= shift;
+        };
+        clipStart(area.x, dest.x, area.w);
+        clipStart(area.y, dest.y, area.h);
+        area.w = std::min({area.w, src.width - area.x, width - dest.x});
+        area.h = std::min({area.h, src.height - area.y, height - dest.y});
+        return area.w > 0 && area.h > 0;
+    }
 };
 
+using TileMap8 = BasicTileMap<std::uint8_t>;
+using TileMap16 = BasicTileMap<std::uint16_t>;
+using TileMap32 = BasicTileMap<std::uint32_t>;
+
+/// @brief The default TileMap, for tilesets of up to 65535 tiles
+using TileMap = TileMap16;
+
 using SharedTileMap = std::shared_ptr<TileMap>;
 
 } // namespace sky
@@ -0,0 +1,282 @@
+#include "Visibility.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace sky;
+
+namespace
+{
+
+/// Transforms from octant 0 coordinates, columns: xx, xy, yx, yy
+constexpr int Octants[8][4] = {{1, 0, 0, 1},  {0, 1, 1, 0},  {0, -1, 1, 0}, {-1, 0, 0, 1},
+                               {-1, 0, 0, -1}, {0, -1, -1, 0}, {0, 1, -1, 0}, {1, 0, 0, -1}};
+
+int floorDiv(int a, int b)
+{
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+BitGrid::BitGrid(int width_, int height_)
+    : width(width_), height(height_), wordsPerRow((width + 63) / 64),
+      words(static_cast<std::size_t>(wordsPerRow * height), 0)
+{
+}
+
+void BitGrid::clear() noexcept
+{
+    std::fill(words.begin(), words.end(), 0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+FieldOfView::FieldOfView(int width, int height)
+    : opaque(width, height), visible(width, height), explored(width, height),
+      viewCount(static_cast<std::size_t>(width * height), 0)
+{
+}
+
+void FieldOfView::setOpaque(const mist::Point2i &p, bool isOpaque)
+{
+    if (opaque.test(p.x, p.y) == isOpaque) return;
+    opaque.set(p.x, p.y, isOpaque);
+    markChanged({p.x, p.y, 1, 1});
+}
+
+void FieldOfView::markChanged(const SDL_Rect &area)
+{
+    for (auto &v : viewers) {
+        if (!v.active || v.dirty) continue;
+        const auto &p = v.position;
+        if (p.x + v.radius >= area.x && p.x - v.radius < area.x + area.w &&
+            p.y + v.radius >= area.y && p.y - v.radius < area.y + area.h) {
+            v.dirty = true;
+        }
+    }
+}
+
+int FieldOfView::addViewer(const mist::Point2i &position, int radius)
+{
+    if (radius < 0) throw std::runtime_error("Field of view: negative radius");
+
+    if (!freeViewers.empty()) {
+        const auto id = freeViewers.back();
+        freeViewers.pop_back();
+        auto &v = viewers[static_cast<std::size_t>(id)];
+        v.position = position;
+        v.radius = radius;
+        v.active = true;
+        v.dirty = true;
+        return id;
+    }
+
+    viewers.push_back({position, radius, true, true, {}});
+    return static_cast<int>(viewers.size()) - 1;
+}
+
+void FieldOfView::removeViewer(int id)
+{
+    auto &v = viewers.at(static_cast<std::size_t>(id));
+    if (!v.active) return;
+
+    release(v);
+    v.active = false;
+    freeViewers.push_back(id);
+}
+
+void FieldOfView::moveViewer(int id, const mist::Point2i &position)
+{
+    auto &v = viewers.at(static_cast<std::size_t>(id));
+    if (v.position == position) return;
+    v.position = position;
+    v.dirty = true;
+}
+
+void FieldOfView::setViewerRadius(int id, int radius)
+{
+    if (radius < 0) throw std::runtime_error("Field of view: negative radius");
+
+    auto &v = viewers.at(static_cast<std::size_t>(id));
+    if (v.radius == radius) return;
+    v.radius = radius;
+    v.dirty = true;
+}
+
+void FieldOfView::update()
+{
+    for (auto &v : viewers)
+        if (v.active && v.dirty) compute(v);
+}
+
+void FieldOfView::resetExplored()
+{
+    explored.clear();
+    for (const auto &v : viewers) {
+        for (const auto cell : v.cells)
+            explored.set(cell % getWidth(), cell / getWidth(), true);
+    }
+}
+
+bool FieldOfView::blocksSight(int x, int y) const noexcept
+{
+    return !opaque.contains(x, y) || opaque.test(x, y);
+}
+
+void FieldOfView::release(Viewer &viewer)
+{
+    const auto w = getWidth();
+    for (const auto cell : viewer.cells) {
+        if (--viewCount[static_cast<std::size_t>(cell)] == 0)
+            visible.set(cell % w, cell / w, false);
+    }
+    viewer.cells.clear();
+}
+
+void FieldOfView::reveal(Viewer &viewer, int x, int y)
+{
+    if (!opaque.contains(x, y)) return;
+
+    // Cells on octant borders are reached twice
+    const auto side = 2 * viewer.radius + 1;
+    const auto local = static_cast<std::size_t>((y - viewer.position.y + viewer.radius) * side +
+                                                x - viewer.position.x + viewer.radius);
+    if (revealed[local] != 0) return;
+    revealed[local] = 1;
+
+    const auto cell = y * getWidth() + x;
+    viewer.cells.push_back(cell);
+    if (viewCount[static_cast<std::size_t>(cell)]++ == 0) {
+        visible.set(x, y, true);
+        explored.set(x, y, true);
+    }
+}
+
+void FieldOfView::compute(Viewer &viewer)
+{
+    release(viewer);
+    viewer.dirty = false;
+
+    const auto side = static_cast<std::size_t>(2 * viewer.radius + 1);
+    revealed.assign(side * side, 0);
+
+    reveal(viewer, viewer.position.x, viewer.position.y);
+    for (const auto &o : Octants)
+        castLight(viewer, 1, 1.0f, 0.0f, o[0], o[1], o[2], o[3]);
+}
+
+void FieldOfView::castLight(Viewer &viewer, int row, float start, float end, int xx, int xy,
+                            int yx, int yy)
+{
+    if (start < end) return;
+
+    const auto radius = viewer.radius;
+    const auto cx = viewer.position.x;
+    const auto cy = viewer.position.y;
+    float      newStart = 0;
+
+    for (int j = row; j <= radius; j++) {
+        const auto dy = -j;
+        bool       blocked = false;
+
+        for (int dx = -j; dx <= 0; dx++) {
+            const auto x = cx + dx * xx + dy * xy;
+            const auto y = cy + dx * yx + dy * yy;
+            const auto fx = static_cast<float>(dx);
+            const auto fy = static_cast<float>(dy);
+            const auto leftSlope = (fx - 0.5f) / (fy + 0.5f);
+            const auto rightSlope = (fx + 0.5f) / (fy - 0.5f);
+
+            if (start < rightSlope) continue;
+            if (end > leftSlope) break;
+
+            if (dx * dx + dy * dy <= radius * radius) reveal(viewer, x, y);
+
+            if (blocked) {
+                if (blocksSight(x, y)) {
+                    newStart = rightSlope;
+                } else {
+                    blocked = false;
+                    start = newStart;
+                }
+            } else if (blocksSight(x, y) && j < radius) {
+                // Scan the part of the next row that is still lit, then continue past the wall
+                blocked = true;
+                castLight(viewer, j + 1, start, leftSlope, xx, xy, yx, yy);
+                newStart = rightSlope;
+            }
+        }
+        if (blocked) break;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+FogOverlay::FogOverlay(SharedFieldOfView fov_, int tileSize_)
+    : fov(std::move(fov_)), tileSize(tileSize_)
+{
+}
+
+void FogOverlay::setColors(const Color &unexplored, const Color &remembered)
+{
+    unexploredColor = unexplored;
+    rememberedColor = remembered;
+}
+
+void FogOverlay::draw(Renderer &renderer, int x, int y, double)
+{
+    int screenWidth = 0;
+    int screenHeight = 0;
+    SDL_GetRendererOutputSize(renderer, &screenWidth, &screenHeight);
+
+    // Visible tile range; x, y is the screen position of tile (0, 0)
+    const auto tx0 = std::max(0, floorDiv(-x, tileSize));
+    const auto ty0 = std::max(0, floorDiv(-y, tileSize));
+    const auto tx1 = std::min(fov->getWidth() - 1, floorDiv(screenWidth - x - 1, tileSize));
+    const auto ty1 = std::min(fov->getHeight() - 1, floorDiv(screenHeight - y - 1, tileSize));
+
+    unexploredRects.clear();
+    rememberedRects.clear();
+
+    const auto &visible = fov->getVisible();
+    const auto &explored = fov->getExplored();
+    for (int ty = ty0; ty <= ty1; ty++) {
+        // Merge runs of cells with the same shade into one rect
+        int tx = tx0;
+        while (tx <= tx1) {
+            if (visible.test(tx, ty)) {
+                tx++;
+                continue;
+            }
+
+            const auto isExplored = explored.test(tx, ty);
+            const auto runStart = tx;
+            while (tx + 1 <= tx1 && !visible.test(tx + 1, ty) &&
+                   explored.test(tx + 1, ty) == isExplored) {
+                tx++;
+            }
+
+            SDL_Rect rect {x + runStart * tileSize, y + ty * tileSize,
+                           (tx - runStart + 1) * tileSize, tileSize};
+            (isExplored ? rememberedRects : unexploredRects).push_back(rect);
+            tx++;
+        }
+    }
+
+    SDL_BlendMode previousBlendMode;
+    SDL_GetRenderDrawBlendMode(renderer, &previousBlendMode);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    auto fill = [&](const std::vector<SDL_Rect> &rects, const Color &c) {
+        if (rects.empty()) return;
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+        SDL_RenderFillRects(renderer, rects.data(), static_cast<int>(rects.size()));
+        renderer.countDrawCalls();
+    };
+    fill(unexploredRects, unexploredColor);
+    fill(rememberedRects, rememberedColor);
+    SDL_SetRenderDrawBlendMode(renderer, previousBlendMode);
+}
@@ -0,0 +1,185 @@
+#ifndef SKY_VISIBILITY_H_
+#define SKY_VISIBILITY_H_
+
+#include "Color.h"
+#include "SkyEngine.h"
+#include "Tiles.h"
+
+#include <mist/Point.h>
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace sky
+{
+
+/// @brief A grid of bits, 64 cells per word, each row starting at a new word
+class BitGrid
+{
+public:
+    BitGrid(int width, int height);
+
+    [[nodiscard]] int getWidth() const noexcept { return width; }
+    [[nodiscard]] int getHeight() const noexcept { return height; }
+
+    [[nodiscard]] bool contains(int x, int y) const noexcept
+    {
+        return x >= 0 && y >= 0 && x < width && y < height;
+    }
+
+    [[nodiscard]] bool test(int x, int y) const noexcept
+    {
+        return (words[word(x, y)] >> (x & 63) & 1u) != 0;
+    }
+
+    void set(int x, int y, bool value) noexcept
+    {
+        const auto bit = std::uint64_t {1} << (x & 63);
+        if (value)
+            words[word(x, y)] |= bit;
+        else
+            words[word(x, y)] &= ~bit;
+    }
+
+    void clear() noexcept;
+
+    [[nodiscard]] std::span<const std::uint64_t> getRow(int y) const noexcept
+    {
+        return std::span(words).subspan(static_cast<std::size_t>(y * wordsPerRow),
+                                        static_cast<std::size_t>(wordsPerRow));
+    }
+
+private:
+    int                        width;
+    int                        height;
+    int                        wordsPerRow;
+    std::vector<std::uint64_t> words;
+
+    [[nodiscard]] std::size_t word(int x, int y) const noexcept
+    {
+        return static_cast<std::size_t>(y * wordsPerRow + (x >> 6));
+    }
+};
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Field of view of any number of viewers on a tile grid
+ *
+ * Visibility is computed with recursive shadowcasting, within a circular radius around each
+ * viewer. Cells outside the grid block sight. The union of what all viewers see is kept in a
+ * single BitGrid, and every cell ever seen is remembered as explored.
+ *
+ * update() only recomputes viewers that moved, changed their radius, or have changed opaque
+ * cells within their radius. Per-cell viewer counts keep the union up to date without
+ * clearing it, so the cost of an update is proportional to the recomputed viewers only.
+ */
+class FieldOfView
+{
+public:
+    FieldOfView(int width, int height);
+
+    template <class Cell, class Predicate>
+    void updateOpacity(const BasicTileMap<Cell> &map, Predicate isOpaque, const SDL_Rect &area,
+                       int layer = 0)
+    {
+        for (int y = area.y; y < area.y + area.h; y++)
+            for (int x = area.x; x < area.x + area.w; x++)
+                opaque.set(x, y, isOpaque(map.at(layer, {x, y})));
+        markChanged(area);
+    }
+
+    void setOpaque(const mist::Point2i &p, bool isOpaque);
+
+    /// @brief Recompute viewers that can see any cell of the area
+    void markChanged(const SDL_Rect &area);
+
+    /// @return viewer id
+    int  addViewer(const mist::Point2i &position, int radius);
+    void removeViewer(int id);
+    void moveViewer(int id, const mist::Point2i &position);
+    void setViewerRadius(int id, int radius);
+
+    /// @brief Recompute dirty viewers
+    void update();
+
+    /// @brief Forget explored cells, e.g. when entering a new level
+    void resetExplored();
+
+    [[nodiscard]] int getWidth() const noexcept { return opaque.getWidth(); }
+    [[nodiscard]] int getHeight() const noexcept { return opaque.getHeight(); }
+
+    [[nodiscard]] bool isVisible(int x, int y) const noexcept
+    {
+        return visible.contains(x, y) && visible.test(x, y);
+    }
+
+    [[nodiscard]] bool isExplored(int x, int y) const noexcept
+    {
+        return explored.contains(x, y) && explored.test(x, y);
+    }
+
+    [[nodiscard]] const BitGrid &getVisible() const noexcept { return visible; }
+    [[nodiscard]] const BitGrid &getExplored() const noexcept { return explored; }
+
+private:
+    struct Viewer {
+        mist::Point2i    position;
+        int              radius;
+        bool             active;
+        bool             dirty;
+        std::vector<int> cells; ///< visible cell indices, y * width + x
+    };
+
+    BitGrid                    opaque;
+    BitGrid                    visible;
+    BitGrid                    explored;
+    std::vector<std::uint16_t> viewCount;
+    std::vector<Viewer>        viewers;
+    std::vector<int>           freeViewers;
+    std::vector<std::uint8_t>  revealed; ///< scratch, cells around the viewer being computed
+
+    void compute(Viewer &viewer);
+    void castLight(Viewer &viewer, int row, float start, float end, int xx, int xy, int yx,
+                   int yy);
+    void reveal(Viewer &viewer, int x, int y);
+    void release(Viewer &viewer);
+    [[nodiscard]] bool blocksSight(int x, int y) const noexcept;
+};
+
+using SharedFieldOfView = std::shared_ptr<FieldOfView>;
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * @brief Darkens tiles not visible in a FieldOfView
+ *
+ * Draw on top of the tile map, at the same position. Runs of cells with the same shade are
+ * merged into rectangles, and each shade is drawn with a single SDL_RenderFillRects() call.
+ */
+class FogOverlay : public Drawable
+{
+public:
+    FogOverlay(SharedFieldOfView fov, int tileSize);
+
+    /// @arg unexplored color of cells never seen
+    /// @arg remembered color of explored cells not visible now
+    void setColors(const Color &unexplored, const Color &remembered);
+
+    void draw(Renderer &renderer, int x, int y, double angle) override;
+
+private:
+    SharedFieldOfView     fov;
+    int                   tileSize;
+    Color                 unexploredColor {0, 0, 0, 255};
+    Color                 rememberedColor {0, 0, 0, 160};
+    std::vector<SDL_Rect> unexploredRects;
+    std::vector<SDL_Rect> rememberedRects;
+};
+
+} // namespace sky
+
+#endif
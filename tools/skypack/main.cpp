@@ -0,0 +1,55 @@
+#include <AssetPack.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+constexpr auto Usage = "Usage: skypack [-z] <output.pack> <file>...\n"
+                       "\n"
+                       "Entries are named by the file paths as given, e.g. res/default.ttf,\n"
+                       "which is how resources loaded from the pack are referred to.\n"
+                       "\n"
+                       "  -z  compress entries with LZ4, if that makes them smaller";
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string_view> args(argv + 1, argv + argc);
+
+    bool compress = false;
+    if (!args.empty() && args.front() == "-z") {
+        compress = true;
+        args.erase(args.begin());
+    }
+    if (args.size() < 2) {
+        spdlog::error(Usage);
+        return 1;
+    }
+
+    std::vector<sky::AssetPack::Source> sources;
+    for (auto it = args.begin() + 1; it != args.end(); ++it) {
+        std::string name {*it};
+        std::replace(name.begin(), name.end(), '\\', '/');
+        sources.push_back({name, std::string {*it}});
+    }
+
+    try {
+        const std::string output {args.front()};
+        sky::AssetPack::write(output.c_str(), std::move(sources), compress);
+        spdlog::info("Packed {} files into {}", args.size() - 1, output);
+    }
+
+    catch (std::exception &e) {
+        spdlog::critical(e.what());
+        return 1;
+    }
+
+    return 0;
+}